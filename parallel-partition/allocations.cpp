@@ -0,0 +1,145 @@
+// allocations.cpp                                                   -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#include "thread_pool.hpp"
+#include "parallel_sort.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Counts the calls to operator new: for the std::function<void()> based job
+// queue formerly used by nstd::thread_pool, for nstd::thread_pool itself,
+// and per call to parallel_partition2 and parallel_sort_with_async.
+
+namespace {
+    std::atomic<long> allocations(0);
+}
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* rc = std::malloc(size? size: 1u)) {
+        return rc;
+    }
+    throw std::bad_alloc();
+}
+#if defined(__GNUC__) && !defined(__clang__) && 11 <= __GNUC__
+#pragma GCC diagnostic push
+// the replacement operator new uses malloc(), i.e., free() is the match
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+#if defined(__GNUC__) && !defined(__clang__) && 11 <= __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+// ----------------------------------------------------------------------------
+
+template <typename Fun>
+long count(int repeat, Fun fun) {
+    fun(); // warm-up
+    long before(allocations);
+    for (int i(0); i != repeat; ++i) {
+        fun();
+    }
+    return (allocations - before) / repeat;
+}
+
+void report(std::string const& name, long value) {
+    std::cout << std::setw(60) << name << ' ' << value << '\n' << std::flush;
+}
+
+// ----------------------------------------------------------------------------
+
+int main() {
+    try {
+        constexpr int jobs = 10000;
+        using iterator = std::vector<int>::iterator;
+        auto ctrl = std::make_shared<int>(0);
+        iterator begin{}, end{};
+        auto closure = [ctrl, begin, end]{ (void)begin; (void)end; ++*ctrl; };
+
+        report("std::deque<std::function<void()>> jobs/10000", count(1, [&]{
+                    std::deque<std::function<void()>> queue;
+                    for (int i(0); i != jobs; ++i) {
+                        queue.push_back(closure);
+                        queue.front()();
+                        queue.pop_front();
+                    }
+                }));
+
+        nstd::thread_pool pool(std::thread::hardware_concurrency(),
+                               nstd::thread_pool::mode::work_stealing);
+        pool.start();
+        report("nstd::thread_pool::enqueue_job() jobs/10000", count(1, [&]{
+                    nstd::latch latch(jobs);
+                    for (int i(0); i != jobs; ++i) {
+                        pool.enqueue_job([closure, &latch]{ closure(); latch.arrive(); });
+                    }
+                    latch.wait();
+                }));
+
+        for (int size: { 10000, 100000, 1000000 }) {
+            std::minstd_rand rnd(0);
+            std::vector<int> v;
+            std::generate_n(std::back_inserter(v), size, [size,&rnd]{ return rnd() % size; });
+            nstd::parallel_partition2<nstd::block_manager_relaxed> partition(pool);
+            std::vector<int> p(v);
+            report("parallel_partition2 size=" + std::to_string(size),
+                   count(10, [&]{
+                           partition(p.begin(), p.end(), [size](int value){
+                                   return value < size / 2;
+                               });
+                       }));
+            parallel_sort_with_async<nstd::block_manager_padded_atomic> sort(pool);
+            std::vector<int> c(v);
+            report("parallel_sort_with_async size=" + std::to_string(size),
+                   count(10, [&]{
+                           c = v; // doesn't allocate: the capacity is sufficient
+                           sort(c.begin(), c.end(), std::less<>());
+                       }));
+        }
+    }
+    catch (std::exception const& ex) {
+        std::cerr << "ERROR: " << ex.what() << '\n';
+    }
+}
@@ -0,0 +1,92 @@
+// atomic_wait.hpp                                                   -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#ifndef INCLUDED_ATOMIC_WAIT
+#define INCLUDED_ATOMIC_WAIT
+
+#include <atomic>
+#include <climits>
+#include <thread>
+#if !defined(__cpp_lib_atomic_wait) && defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// ----------------------------------------------------------------------------
+// Blocking on an atomic int until its value changes: atomic_wait() returns
+// when the value may differ from old (spurious returns are possible) and
+// atomic_notify_all() wakes all threads blocked on the atomic. With C++20
+// these are std::atomic<int>::wait() and notify_all(), on Linux a futex is
+// used directly, and elsewhere waiting just yields.
+
+namespace nstd {
+    void atomic_wait(std::atomic<int>& value, int old);
+    void atomic_notify_all(std::atomic<int>& value);
+}
+
+// ----------------------------------------------------------------------------
+
+#if defined(__cpp_lib_atomic_wait)
+
+inline void nstd::atomic_wait(std::atomic<int>& value, int old) {
+    value.wait(old, std::memory_order_acquire);
+}
+
+inline void nstd::atomic_notify_all(std::atomic<int>& value) {
+    value.notify_all();
+}
+
+#elif defined(__linux__)
+
+static_assert(sizeof(std::atomic<int>) == sizeof(int),
+              "futex operations need an std::atomic<int> to be an int");
+
+inline void nstd::atomic_wait(std::atomic<int>& value, int old) {
+    ::syscall(SYS_futex, reinterpret_cast<int*>(&value), FUTEX_WAIT_PRIVATE,
+              old, nullptr, nullptr, 0);
+}
+
+inline void nstd::atomic_notify_all(std::atomic<int>& value) {
+    ::syscall(SYS_futex, reinterpret_cast<int*>(&value), FUTEX_WAKE_PRIVATE,
+              INT_MAX, nullptr, nullptr, 0);
+}
+
+#else
+
+inline void nstd::atomic_wait(std::atomic<int>& value, int old) {
+    if (value.load(std::memory_order_acquire) == old) {
+        std::this_thread::yield();
+    }
+}
+
+inline void nstd::atomic_notify_all(std::atomic<int>&) {
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+
+#endif
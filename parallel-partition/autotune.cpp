@@ -0,0 +1,236 @@
+// autotune.cpp                                                      -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#include "parallel_partition.hpp"
+#include "parallel_sort.hpp"
+#include "thread_pool.hpp"
+#include "topology.hpp"
+#include "tuning.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Calibrates the tuning parameters (see tuning.hpp) for this machine using
+// the default pool and writes the tuning profile, by default to the file
+// the algorithms load it from:
+//
+//   autotune [profile [size]]
+//
+// For each element size the block manager and block size with the fastest
+// tuned_partition are chosen first. Using these, min_blocks is the smallest
+// number of blocks for which the parallel partition beats std::partition,
+// the context parameters are those of the fastest blocked_partition, and
+// the sort cut-off is the one with the fastest parallel_sort_with_async.
+// The candidate parameters are tried using an nstd::tuning_override.
+
+using clock_type = std::chrono::steady_clock;
+
+template <typename T>
+class calibration {
+private:
+    static constexpr int repeat = 5;
+
+    nstd::thread_pool&      d_pool;
+    nstd::tuning_parameters d_tuning;
+    nstd::tuning_override   d_override; // refers to d_tuning
+    std::vector<T>          d_data;
+    T                       d_pivot;
+
+    // the best time in microseconds of running fun on the first n elements
+    template <typename Fun>
+    double measure(std::size_t n, Fun fun) {
+        double rc(std::numeric_limits<double>::max());
+        for (int i(0); i != repeat; ++i) {
+            std::vector<T> copy(this->d_data.begin(), this->d_data.begin() + n);
+            auto start = clock_type::now();
+            fun(copy.begin(), copy.end());
+            std::chrono::duration<double, std::micro> time(clock_type::now() - start);
+            rc = std::min(rc, time.count());
+        }
+        return rc;
+    }
+    template <typename Partition>
+    double partition(std::size_t n, Partition partition) {
+        T pivot(this->d_pivot);
+        return this->measure(n, [&](auto begin, auto end){
+                partition(begin, end, [pivot](T const& value){ return value < pivot; });
+            });
+    }
+
+public:
+    calibration(nstd::thread_pool& pool, nstd::tuning_profile const& profile, std::size_t size)
+        : d_pool(pool)
+        , d_tuning(profile.get(sizeof(T)))
+        , d_override(this->d_tuning)
+        , d_pivot(T(size / 2)) {
+        std::minstd_rand rnd(0);
+        std::generate_n(std::back_inserter(this->d_data), size,
+                        [&rnd, size]{ return T(rnd() % size); });
+        this->d_tuning.element_size = sizeof(T);
+    }
+
+    void block_manager() {
+        std::vector<nstd::block_manager_kind> kinds{
+            nstd::block_manager_kind::mutex,
+            nstd::block_manager_kind::atomic,
+            nstd::block_manager_kind::padded_atomic,
+            nstd::block_manager_kind::relaxed,
+            nstd::block_manager_kind::guided,
+            nstd::block_manager_kind::packed
+        };
+        if (1 < nstd::cpu_topology::instance().node_count()) {
+            kinds.push_back(nstd::block_manager_kind::numa);
+        }
+        nstd::tuning_parameters best(this->d_tuning);
+        double                  best_time(std::numeric_limits<double>::max());
+        int                     min_blocks(this->d_tuning.min_blocks);
+        this->d_tuning.min_blocks = 1;
+        for (auto kind: kinds) {
+            for (int block_size: { 256, 512, 1024, 2048, 4096, 8192 }) {
+                this->d_tuning.block_manager = kind;
+                this->d_tuning.block_size    = block_size;
+                double time(this->partition(this->d_data.size(),
+                                            nstd::tuned_partition<>(this->d_pool)));
+                if (time < best_time) {
+                    best_time = time;
+                    best      = this->d_tuning;
+                }
+            }
+        }
+        best.min_blocks = min_blocks;
+        this->d_tuning = best;
+    }
+    void min_blocks() {
+        int const block_size(this->d_tuning.block_size);
+        this->d_tuning.min_blocks = 1;
+        int rc(64);
+        for (int blocks: { 1, 2, 4, 8, 16, 32, 64 }) {
+            std::size_t n(std::size_t(blocks) * block_size);
+            if (this->d_data.size() < n) {
+                break;
+            }
+            double sequential(this->partition(n, [](auto begin, auto end, auto pred){
+                        return std::partition(begin, end, pred);
+                    }));
+            if (this->partition(n, nstd::tuned_partition<>(this->d_pool)) < sequential) {
+                rc = blocks;
+                break;
+            }
+        }
+        this->d_tuning.min_blocks = rc;
+    }
+    void context() {
+        nstd::tuning_parameters best(this->d_tuning);
+        double                  best_time(std::numeric_limits<double>::max());
+        for (long min_block: { 64, 128, 256, 512, 1024 }) {
+            for (int blocks_per_thread: { 2, 4, 8, 16 }) {
+                this->d_tuning.context_min_block         = min_block;
+                this->d_tuning.context_blocks_per_thread = blocks_per_thread;
+                double time(this->partition(this->d_data.size(), [](auto begin, auto end, auto pred){
+                            return blocked_partition(begin, end, pred);
+                        }));
+                if (time < best_time) {
+                    best_time = time;
+                    best      = this->d_tuning;
+                }
+            }
+        }
+        this->d_tuning = best;
+    }
+    void sort_cutoff() {
+        nstd::tuning_parameters best(this->d_tuning);
+        double                  best_time(std::numeric_limits<double>::max());
+        std::size_t             n(std::min(this->d_data.size(), std::size_t(1) << 20));
+        for (long cutoff: { 1000, 2000, 4000, 8000, 16000, 32000, 64000 }) {
+            this->d_tuning.sort_cutoff = cutoff;
+            parallel_sort_with_async<nstd::block_manager_relaxed> sort(this->d_pool);
+            double time(this->measure(n, [&sort](auto begin, auto end){
+                        sort(begin, end, std::less<>());
+                    }));
+            if (time < best_time) {
+                best_time = time;
+                best      = this->d_tuning;
+            }
+        }
+        this->d_tuning = best;
+    }
+
+    nstd::tuning_parameters run() {
+        this->block_manager();
+        this->min_blocks();
+        this->context();
+        this->sort_cutoff();
+        return this->d_tuning;
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+void report(nstd::tuning_parameters const& tuning) {
+    std::cout << "element_size=" << tuning.element_size << ' '
+              << "block_size=" << tuning.block_size << ' '
+              << "min_blocks=" << tuning.min_blocks << ' '
+              << "sort_cutoff=" << tuning.sort_cutoff << ' '
+              << "context_min_block=" << tuning.context_min_block << ' '
+              << "context_blocks_per_thread=" << tuning.context_blocks_per_thread << ' '
+              << "block_manager=" << nstd::to_string(tuning.block_manager)
+              << '\n' << std::flush;
+}
+
+int main(int ac, char* av[]) {
+    try {
+        std::string path(1 < ac? av[1]: nstd::tuning_profile::default_path());
+        std::size_t size(2 < ac? std::strtoull(av[2], nullptr, 10): std::size_t(1) << 22);
+        nstd::thread_pool&   pool(nstd::default_pool());
+        nstd::tuning_profile profile(nstd::tuning_profile::default_path());
+
+        auto tuning = calibration<int>(pool, profile, size).run();
+        report(tuning);
+        profile.set(tuning);
+        auto wide = calibration<long long>(pool, profile, size).run();
+        report(wide);
+        profile.set(wide);
+        tuning.element_size = 0u;
+        profile.set(tuning);
+
+        if (path.empty() || !profile.save(path)) {
+            std::cerr << "ERROR: failed to write the tuning profile '" << path << "'\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << "tuning profile written to " << path << '\n';
+    }
+    catch (std::exception const& ex) {
+        std::cerr << "ERROR: " << ex.what() << '\n';
+    }
+}
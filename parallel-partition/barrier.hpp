@@ -0,0 +1,106 @@
+// barrier.hpp                                                       -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#ifndef INCLUDED_BARRIER
+#define INCLUDED_BARRIER
+
+#include "atomic_wait.hpp"
+#include "idle_policy.hpp"
+#include <atomic>
+#include <utility>
+
+// ----------------------------------------------------------------------------
+// A reusable barrier for multi-phase algorithms: each phase completes when
+// count threads called arrive_and_wait(). The last thread to arrive runs the
+// completion step before the others are released into the next phase, e.g.,
+// to compute the fix-up ranges between the claim and cleanup phases of a
+// parallel partition. Like nstd::latch, the phase word carries a flag for
+// blocked threads (the lowest bit) such that waking them up is only done
+// when needed.
+
+namespace nstd {
+    struct no_completion;
+    template <typename Completion = nstd::no_completion>
+    class barrier;
+}
+
+// ----------------------------------------------------------------------------
+
+struct nstd::no_completion {
+    void operator()() const noexcept {}
+};
+
+// ----------------------------------------------------------------------------
+
+template <typename Completion>
+class nstd::barrier {
+private:
+    static constexpr int spins = 128;
+
+    int              d_expected;
+    std::atomic<int> d_count;
+    std::atomic<int> d_phase;
+    Completion       d_completion;
+
+public:
+    explicit barrier(int count, Completion completion = Completion())
+        : d_expected(count)
+        , d_count(count)
+        , d_phase(0)
+        , d_completion(std::move(completion)) {
+    }
+    barrier(barrier&) = delete;
+    void operator=(barrier&) = delete;
+
+    void arrive_and_wait() {
+        int phase(this->d_phase.load(std::memory_order_acquire) & ~1);
+        if (1 == this->d_count.fetch_sub(1, std::memory_order_acq_rel)) {
+            this->d_completion();
+            this->d_count.store(this->d_expected, std::memory_order_relaxed);
+            int next(int(unsigned(phase) + 2u)); // wrapping around is fine
+            if (this->d_phase.exchange(next, std::memory_order_acq_rel) & 1) {
+                nstd::atomic_notify_all(this->d_phase);
+            }
+            return;
+        }
+        for (int i(0); i != spins; ++i) {
+            if ((this->d_phase.load(std::memory_order_acquire) & ~1) != phase) {
+                return;
+            }
+            nstd::cpu_relax();
+        }
+        int current(this->d_phase.load(std::memory_order_acquire));
+        while ((current & ~1) == phase) {
+            if ((current & 1) || this->d_phase.compare_exchange_weak(current, current | 1)) {
+                nstd::atomic_wait(this->d_phase, current | 1);
+                current = this->d_phase.load(std::memory_order_acquire);
+            }
+        }
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+#endif
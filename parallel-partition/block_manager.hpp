@@ -26,19 +26,32 @@
 #ifndef INCLUDED_BLOCK_MANAGER
 #define INCLUDED_BLOCK_MANAGER
 
+#include "topology.hpp"
 #include <atomic>
 #include <mutex>
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <cassert>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <utility>
 
 // ----------------------------------------------------------------------------
+// The block managers hand out blocks of up to Size elements from the front
+// and the back of the range [begin, end). Sizes and offsets use the
+// iterator's difference_type, i.e., ranges with more than INT_MAX elements
+// are fine.
 
 namespace nstd {
     template <typename RndIt, int Size> class block_manager;
     template <typename RndIt, int Size> class block_manager_atomic;
     template <typename RndIt, int Size> class block_manager_padded_atomic;
     template <typename RndIt, int Size> class block_manager_relaxed;
+    template <typename RndIt, int Size> class block_manager_guided;
+    template <typename RndIt, int Size> class block_manager_packed;
+    template <typename RndIt, int Size> class block_manager_numa;
 }
 
 // ----------------------------------------------------------------------------
@@ -46,6 +59,8 @@ namespace nstd {
 template <typename RndIt, int Size>
 class nstd::block_manager {
 private:
+    using difference_type = typename std::iterator_traits<RndIt>::difference_type;
+
     RndIt      d_begin;
     RndIt      d_end;
     std::mutex d_mutex;
@@ -59,14 +74,14 @@ public:
     auto midpoint() -> RndIt { return this->d_begin; }
     auto pop_front() -> std::pair<RndIt, RndIt> {
         std::lock_guard<std::mutex> kerberos(this->d_mutex);
-        auto end = this->d_begin + std::min(Size, int(std::distance(this->d_begin, d_end)));
+        auto end = this->d_begin + std::min(difference_type(Size), std::distance(this->d_begin, d_end));
         auto rc = std::make_pair(this->d_begin, end);
         this->d_begin = end;
         return rc;
     }
     auto pop_back() -> std::pair<RndIt, RndIt> {
         std::lock_guard<std::mutex> kerberos(this->d_mutex);
-        auto begin = this->d_end - std::min(Size, int(std::distance(this->d_begin, d_end)));
+        auto begin = this->d_end - std::min(difference_type(Size), std::distance(this->d_begin, d_end));
         auto rc = std::make_pair(begin, this->d_end);
         this->d_end = begin;
         return rc;
@@ -78,15 +93,17 @@ public:
 template <typename RndIt, int Size>
 class nstd::block_manager_atomic {
 private:
-    RndIt            d_begin;
-    RndIt            d_end;
-    std::atomic<int> d_size_left;
-    std::atomic<int> d_offset_front;
-    std::atomic<int> d_offset_back;
-    int elements_remaining() {
-        int result = this->d_size_left -= Size;
+    using difference_type = typename std::iterator_traits<RndIt>::difference_type;
+
+    RndIt                        d_begin;
+    RndIt                        d_end;
+    std::atomic<difference_type> d_size_left;
+    std::atomic<difference_type> d_offset_front;
+    std::atomic<difference_type> d_offset_back;
+    difference_type elements_remaining() {
+        difference_type result = this->d_size_left -= Size;
         if (0 <= result)    { return Size; } // Size elements obtained
-        return std::max(0, Size + result);
+        return std::max(difference_type(0), Size + result);
     }
 public:
     explicit block_manager_atomic(RndIt begin, RndIt end)
@@ -98,14 +115,14 @@ public:
     }
     auto midpoint() const { return this->d_begin + this->d_offset_front; }
     auto pop_front() -> std::pair<RndIt, RndIt> {
-        int elements = this->elements_remaining();
-        int offset   = this->d_offset_front += elements;
+        difference_type elements = this->elements_remaining();
+        difference_type offset   = this->d_offset_front += elements;
         return std::make_pair(this->d_begin + offset - elements,
                               this->d_begin + offset);
     }
     auto pop_back() -> std::pair<RndIt, RndIt> {
-        int elements = this->elements_remaining();
-        int offset   = this->d_offset_back += elements;
+        difference_type elements = this->elements_remaining();
+        difference_type offset   = this->d_offset_back += elements;
         return std::make_pair(this->d_end - offset,
                               this->d_end - offset + elements);
     }
@@ -116,16 +133,18 @@ public:
 template <typename RndIt, int Size>
 class nstd::block_manager_padded_atomic {
 private:
-    RndIt            d_begin;
-    RndIt            d_end;
-    alignas(64) std::atomic<int> d_size_left;
-    alignas(64) std::atomic<int> d_offset_front;
-    alignas(64) std::atomic<int> d_offset_back;
-
-    int elements_remaining() {
-        int result = this->d_size_left -= Size;
+    using difference_type = typename std::iterator_traits<RndIt>::difference_type;
+
+    RndIt                        d_begin;
+    RndIt                        d_end;
+    alignas(64) std::atomic<difference_type> d_size_left;
+    alignas(64) std::atomic<difference_type> d_offset_front;
+    alignas(64) std::atomic<difference_type> d_offset_back;
+
+    difference_type elements_remaining() {
+        difference_type result = this->d_size_left -= Size;
         if (0 <= result)    { return Size; } // Size elements obtained
-        return std::max(0, Size + result);
+        return std::max(difference_type(0), Size + result);
     }
 public:
     explicit block_manager_padded_atomic(RndIt begin, RndIt end)
@@ -137,14 +156,14 @@ public:
     }
     auto midpoint() const { return this->d_begin + this->d_offset_front; }
     auto pop_front() -> std::pair<RndIt, RndIt> {
-        int elements = this->elements_remaining();
-        int offset   = d_offset_front += elements;
+        difference_type elements = this->elements_remaining();
+        difference_type offset   = d_offset_front += elements;
         return std::make_pair((this->d_begin + offset) - elements,
                               this->d_begin + offset);
     }
     auto pop_back() -> std::pair<RndIt, RndIt> {
-        int elements = this->elements_remaining();
-        int offset   = d_offset_back += elements;
+        difference_type elements = this->elements_remaining();
+        difference_type offset   = d_offset_back += elements;
         return std::make_pair(this->d_end - offset,
                               (this->d_end - offset) + elements);
     }
@@ -155,17 +174,19 @@ public:
 template <typename RndIt, int Size>
 class nstd::block_manager_relaxed {
 private:
-    RndIt            d_begin;
-    RndIt            d_end;
-    alignas(64) std::atomic<int> d_size_left;
-    alignas(64) std::atomic<int> d_offset_front;
-    alignas(64) std::atomic<int> d_offset_back;
-
-    int elements_remaining() {
-        int result   = d_size_left.fetch_sub(Size, std::memory_order_relaxed);
+    using difference_type = typename std::iterator_traits<RndIt>::difference_type;
+
+    RndIt                        d_begin;
+    RndIt                        d_end;
+    alignas(64) std::atomic<difference_type> d_size_left;
+    alignas(64) std::atomic<difference_type> d_offset_front;
+    alignas(64) std::atomic<difference_type> d_offset_back;
+
+    difference_type elements_remaining() {
+        difference_type result = d_size_left.fetch_sub(Size, std::memory_order_relaxed);
         result -= Size;
         if (0 <= result)    { return Size; } // Size elements obtained
-        return std::max(0, Size + result);
+        return std::max(difference_type(0), Size + result);
     }
 public:
     explicit block_manager_relaxed(RndIt begin, RndIt end)
@@ -177,21 +198,228 @@ public:
     }
     auto midpoint() const { return this->d_begin + this->d_offset_front; }
     auto pop_front() -> std::pair<RndIt, RndIt> {
-        int elements = this->elements_remaining();
-        int offset   = d_offset_front.fetch_add(elements, std::memory_order_relaxed);
+        difference_type elements = this->elements_remaining();
+        difference_type offset   = d_offset_front.fetch_add(elements, std::memory_order_relaxed);
         offset += elements;
         return std::make_pair((this->d_begin + offset) - elements,
                               this->d_begin + offset);
     }
     auto pop_back() -> std::pair<RndIt, RndIt> {
-        int elements = this->elements_remaining();
-        int offset   = d_offset_back.fetch_add(elements, std::memory_order_relaxed);
+        difference_type elements = this->elements_remaining();
+        difference_type offset   = d_offset_back.fetch_add(elements, std::memory_order_relaxed);
         offset += elements;
         return std::make_pair(this->d_end - offset,
                               (this->d_end - offset) + elements);
     }
 };
 
+// ----------------------------------------------------------------------------
+// Guided scheduling: the blocks start large, proportional to the remaining
+// elements per thread, and shrink while the range drains down to Size
+// elements. Early on there are few atomic operations on the shared
+// counters and at the end the blocks are small, keeping the threads
+// balanced and the leftover fix-up short. The block size depends on the
+// remaining size which is, thus, updated using compare_exchange rather than
+// fetch_sub: there is no over-claiming, either. As each thread holds a block
+// from both ends, a block is at most a quarter of the per-thread share.
+
+template <typename RndIt, int Size>
+class nstd::block_manager_guided {
+private:
+    using difference_type = typename std::iterator_traits<RndIt>::difference_type;
+
+    RndIt                        d_begin;
+    RndIt                        d_end;
+    difference_type              d_divisor;
+    alignas(64) std::atomic<difference_type> d_size_left;
+    alignas(64) std::atomic<difference_type> d_offset_front;
+    alignas(64) std::atomic<difference_type> d_offset_back;
+
+    difference_type elements_remaining() {
+        difference_type left = d_size_left.load(std::memory_order_relaxed);
+        difference_type elements;
+        do {
+            elements = std::min(left, std::max(difference_type(Size), left / this->d_divisor));
+        }
+        while (!d_size_left.compare_exchange_weak(left, left - elements,
+                                                  std::memory_order_relaxed));
+        return elements;
+    }
+public:
+    explicit block_manager_guided(RndIt begin, RndIt end)
+        : d_begin(begin)
+        , d_end(end)
+        , d_divisor(4 * std::max(1u, std::thread::hardware_concurrency()))
+        , d_size_left(std::distance(this->d_begin, this->d_end))
+        , d_offset_front(0u)
+        , d_offset_back(0u) {
+    }
+    auto midpoint() const { return this->d_begin + this->d_offset_front; }
+    auto pop_front() -> std::pair<RndIt, RndIt> {
+        difference_type elements = this->elements_remaining();
+        difference_type offset   = d_offset_front.fetch_add(elements, std::memory_order_relaxed);
+        offset += elements;
+        return std::make_pair((this->d_begin + offset) - elements,
+                              this->d_begin + offset);
+    }
+    auto pop_back() -> std::pair<RndIt, RndIt> {
+        difference_type elements = this->elements_remaining();
+        difference_type offset   = d_offset_back.fetch_add(elements, std::memory_order_relaxed);
+        offset += elements;
+        return std::make_pair(this->d_end - offset,
+                              (this->d_end - offset) + elements);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// The number of blocks taken from the front (upper 32 bits) and from the
+// back (lower 32 bits) are packed into one word: a claim is a single
+// fetch_add on one cache line instead of updating a remaining size and an
+// offset. The values before the increment determine the block: the claim
+// fails if the blocks taken before already cover the range. The thread
+// taking the last, possibly short, block records the midpoint as the
+// counters include the failed claims.
+
+template <typename RndIt, int Size>
+class nstd::block_manager_packed {
+private:
+    using difference_type = typename std::iterator_traits<RndIt>::difference_type;
+    static constexpr std::uint64_t front_block = std::uint64_t(1) << 32;
+    static constexpr std::uint64_t back_block  = 1u;
+
+    RndIt                        d_begin;
+    RndIt                        d_end;
+    difference_type              d_size;
+    RndIt                        d_midpoint;
+    alignas(64) std::atomic<std::uint64_t> d_blocks;
+public:
+    explicit block_manager_packed(RndIt begin, RndIt end)
+        : d_begin(begin)
+        , d_end(end)
+        , d_size(std::distance(begin, end))
+        , d_midpoint(begin)
+        , d_blocks(0u) {
+        assert(this->d_size / Size < difference_type(1) << 31);
+    }
+    auto midpoint() const { return this->d_midpoint; }
+    auto pop_front() -> std::pair<RndIt, RndIt> {
+        std::uint64_t blocks(this->d_blocks.fetch_add(front_block, std::memory_order_relaxed));
+        difference_type front(difference_type(blocks >> 32));
+        difference_type taken((front + difference_type(blocks & 0xffffffffu)) * Size);
+        if (this->d_size <= taken) {
+            return std::make_pair(this->d_end, this->d_end);
+        }
+        difference_type elements(std::min(difference_type(Size), this->d_size - taken));
+        RndIt           begin(this->d_begin + front * Size);
+        if (this->d_size == taken + elements) {
+            this->d_midpoint = begin + elements;
+        }
+        return std::make_pair(begin, begin + elements);
+    }
+    auto pop_back() -> std::pair<RndIt, RndIt> {
+        std::uint64_t blocks(this->d_blocks.fetch_add(back_block, std::memory_order_relaxed));
+        difference_type back(difference_type(blocks & 0xffffffffu));
+        difference_type taken((difference_type(blocks >> 32) + back) * Size);
+        if (this->d_size <= taken) {
+            return std::make_pair(this->d_end, this->d_end);
+        }
+        difference_type elements(std::min(difference_type(Size), this->d_size - taken));
+        RndIt           end(this->d_end - back * Size);
+        if (this->d_size == taken + elements) {
+            this->d_midpoint = end - elements;
+        }
+        return std::make_pair(end - elements, end);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// The range is split into one part per NUMA node, e.g., matching the layout
+// produced by nstd::first_touch(). Threads claim blocks from the front and
+// the back of their own node's part and only steal from the other nodes'
+// parts once their own part is exhausted. Blocks are claimed within a part
+// like nstd::block_manager_packed does for the whole range. Pairing a
+// front block of one part with a back block of another part is fine: each
+// fully processed front block contains only elements satisfying the
+// predicate and each fully processed back block only other elements.
+//
+// There is a midpoint per part rather than one for the whole range, i.e.,
+// the leftovers are merged using nstd::finish_partition() (see
+// parallel_partition.hpp) which also moves the parts' results together.
+
+template <typename RndIt, int Size>
+class nstd::block_manager_numa {
+private:
+    using difference_type = typename std::iterator_traits<RndIt>::difference_type;
+    static constexpr std::uint64_t front_block = std::uint64_t(1) << 32;
+    static constexpr std::uint64_t back_block  = 1u;
+
+    struct part {
+        std::atomic<std::uint64_t> d_blocks;
+        RndIt                      d_begin;
+        RndIt                      d_end;
+        RndIt                      d_midpoint;
+        difference_type            d_size;
+        char                       d_padding[64]; // the counters don't share cache lines
+    };
+
+    RndIt                   d_end;
+    int                     d_nodes;
+    std::unique_ptr<part[]> d_parts;
+
+    auto claim(part& p, bool front) -> std::pair<RndIt, RndIt> {
+        std::uint64_t blocks(p.d_blocks.fetch_add(front? front_block: back_block,
+                                                  std::memory_order_relaxed));
+        difference_type fronts(difference_type(blocks >> 32));
+        difference_type backs(difference_type(blocks & 0xffffffffu));
+        difference_type taken((fronts + backs) * Size);
+        if (p.d_size <= taken) {
+            return std::make_pair(this->d_end, this->d_end);
+        }
+        difference_type elements(std::min(difference_type(Size), p.d_size - taken));
+        RndIt           begin(front? p.d_begin + fronts * Size: p.d_end - backs * Size - elements);
+        if (p.d_size == taken + elements) {
+            p.d_midpoint = front? begin + elements: begin;
+        }
+        return std::make_pair(begin, begin + elements);
+    }
+    auto pop(bool front) -> std::pair<RndIt, RndIt> {
+        int home(nstd::cpu_topology::instance().current_node() % this->d_nodes);
+        for (int i(0); i != this->d_nodes; ++i) {
+            auto rc(this->claim(this->d_parts[(home + i) % this->d_nodes], front));
+            if (rc.first != rc.second) {
+                return rc;
+            }
+        }
+        return std::make_pair(this->d_end, this->d_end);
+    }
+
+public:
+    explicit block_manager_numa(RndIt begin, RndIt end)
+        : block_manager_numa(begin, end, nstd::cpu_topology::instance().node_count()) {
+    }
+    block_manager_numa(RndIt begin, RndIt end, int nodes)
+        : d_end(end)
+        , d_nodes(std::max(1, nodes))
+        , d_parts(new part[this->d_nodes]) {
+        difference_type size(std::distance(begin, end));
+        for (int node(0); node != this->d_nodes; ++node) {
+            part& p(this->d_parts[node]);
+            p.d_blocks   = 0u;
+            p.d_begin    = begin + size * node / this->d_nodes;
+            p.d_end      = begin + size * (node + 1) / this->d_nodes;
+            p.d_midpoint = p.d_begin;
+            p.d_size     = std::distance(p.d_begin, p.d_end);
+            assert(p.d_size / Size < difference_type(1) << 31);
+        }
+    }
+    int   parts() const               { return this->d_nodes; }
+    RndIt begin(int part) const       { return this->d_parts[part].d_begin; }
+    RndIt midpoint(int part) const    { return this->d_parts[part].d_midpoint; }
+    RndIt end(int part) const         { return this->d_parts[part].d_end; }
+    auto pop_front() -> std::pair<RndIt, RndIt> { return this->pop(true); }
+    auto pop_back() -> std::pair<RndIt, RndIt>  { return this->pop(false); }
+};
+
 // ----------------------------------------------------------------------------
 
 #endif
@@ -0,0 +1,158 @@
+// contention.cpp                                                    -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#include "block_manager.hpp"
+#include "barrier.hpp"
+#include "idle_policy.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Measures the block managers on their own: threads alternately claim
+// blocks from the front and the back, optionally spinning a little per
+// block, until both ends are exhausted. The report shows the time per
+// claim, the fairness (the largest share of elements a thread got relative
+// to an even share), and the failed claims: with the fetch_sub based block
+// managers each failed claim moves the remaining size further below zero.
+// The claimed blocks are checked to cover the range exactly once.
+
+using iterator = std::vector<int>::iterator;
+using range    = std::pair<iterator, iterator>;
+
+struct thread_result {
+    std::chrono::steady_clock::duration time{};
+    long               claims = 0;
+    long               failed = 0;
+    std::ptrdiff_t     elements = 0;
+    std::vector<range> blocks;
+};
+
+bool covers(std::vector<thread_result> const& results, iterator begin, iterator end) {
+    std::vector<range> blocks;
+    for (auto const& result: results) {
+        blocks.insert(blocks.end(), result.blocks.begin(), result.blocks.end());
+    }
+    std::sort(blocks.begin(), blocks.end());
+    for (auto const& block: blocks) {
+        if (block.first != begin) {
+            return false;
+        }
+        begin = block.second;
+    }
+    return begin == end;
+}
+
+template <template <typename, int> class BlockManager>
+void measure(std::string const& name, std::vector<int>& data, int threads, int work) {
+    constexpr int blocksize = 1024;
+    BlockManager<iterator, blocksize> bm(data.begin(), data.end());
+    std::vector<thread_result>        results(threads);
+    nstd::barrier<>                   start(threads);
+
+    std::vector<std::thread> pool;
+    for (int t(0); t != threads; ++t) {
+        pool.emplace_back([&, t]{
+                thread_result& result(results[t]);
+                result.blocks.reserve(2 * data.size() / blocksize / threads + 16);
+                start.arrive_and_wait();
+                auto begin(std::chrono::steady_clock::now());
+                for (bool front(true), back(true); front || back; ) {
+                    for (int side(0); side != 2; ++side) {
+                        bool& active(side == 0? front: back);
+                        if (active) {
+                            range block(side == 0? bm.pop_front(): bm.pop_back());
+                            ++result.claims;
+                            if (block.first == block.second) {
+                                ++result.failed;
+                                active = false;
+                            }
+                            else {
+                                result.elements += block.second - block.first;
+                                result.blocks.push_back(block);
+                                std::ptrdiff_t spins(work * (block.second - block.first) / blocksize);
+                                for (std::ptrdiff_t i(0); i != spins; ++i) {
+                                    nstd::cpu_relax();
+                                }
+                            }
+                        }
+                    }
+                }
+                result.time = std::chrono::steady_clock::now() - begin;
+            });
+    }
+    for (auto& thread: pool) {
+        thread.join();
+    }
+
+    std::chrono::steady_clock::duration time{};
+    long           claims(0), failed(0);
+    std::ptrdiff_t most(0);
+    for (auto const& result: results) {
+        time   += result.time;
+        claims += result.claims;
+        failed += result.failed;
+        most    = std::max(most, result.elements);
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+    std::cout << std::setw(30) << name << ' '
+              << "threads=" << std::setw(3) << threads << ' '
+              << "work=" << std::setw(3) << work << ' '
+              << (covers(results, data.begin(), data.end())? "passed": "\x1b[31mfailed\x1b[0m") << ' '
+              << std::setw(8) << (claims? ns / claims: 0) << "ns/claim "
+              << "fairness=" << std::fixed << std::setprecision(2)
+              << double(most) * threads / data.size() << ' '
+              << "failed=" << failed
+              << '\n' << std::flush;
+}
+
+// ----------------------------------------------------------------------------
+
+int main() {
+    try {
+        std::vector<int> data(1 << 24);
+        int maxthreads(std::max(4u, std::thread::hardware_concurrency()));
+        for (int work: { 0, 64 }) {
+            for (int threads(1); threads <= maxthreads; threads *= 2) {
+                measure<nstd::block_manager>("block_manager", data, threads, work);
+                measure<nstd::block_manager_atomic>("block_manager_atomic", data, threads, work);
+                measure<nstd::block_manager_padded_atomic>("block_manager_padded_atomic", data, threads, work);
+                measure<nstd::block_manager_relaxed>("block_manager_relaxed", data, threads, work);
+                measure<nstd::block_manager_guided>("block_manager_guided", data, threads, work);
+                measure<nstd::block_manager_packed>("block_manager_packed", data, threads, work);
+            }
+        }
+    }
+    catch (std::exception const& ex) {
+        std::cerr << "ERROR: " << ex.what() << '\n';
+    }
+}
@@ -0,0 +1,417 @@
+// coroutine.hpp                                                     -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#ifndef INCLUDED_COROUTINE
+#define INCLUDED_COROUTINE
+
+// ----------------------------------------------------------------------------
+// Coroutine support for nstd::thread_pool. This header requires C++20: when
+// compiled with an older standard it is empty.
+//
+// An nstd::task<T> is a lazily started coroutine producing a T: it starts
+// when it is awaited and resumes the awaiting coroutine upon completion on
+// the thread it completed on. A coroutine gets onto the pool using
+// co_await pool.schedule(). Work is forked using async_bulk() (the same
+// function on many indices) or when_all() (a number of tasks): the awaiting
+// coroutine is resumed by whichever job completes last, i.e., no thread
+// blocks while waiting. sync_wait() bridges into normal functions: it
+// helps with pending jobs while waiting for the result.
+
+#if 202002L <= __cplusplus
+
+#include "thread_pool.hpp"
+#include "latch.hpp"
+#include "block_manager.hpp"
+#include "parallel_partition.hpp"
+#include "tuning.hpp"
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+
+namespace nstd {
+    class task_promise_base;
+    template <typename T> class task_promise;
+    template <typename T = void> class task;
+    class detached_task;
+    class fork_join_state;
+    template <typename Fun> class bulk_awaitable;
+    class when_all_awaitable;
+
+    template <typename Fun>
+    bulk_awaitable<Fun> async_bulk(nstd::thread_pool& pool, int count, Fun fun);
+    when_all_awaitable when_all(nstd::thread_pool& pool, std::vector<nstd::task<void>> tasks);
+    template <typename... Tasks>
+    when_all_awaitable when_all(nstd::thread_pool& pool, Tasks... tasks);
+    template <typename T>
+    T sync_wait(nstd::thread_pool& pool, nstd::task<T> task);
+
+    template <template <typename, int> class BlockManager, int BlockSize,
+              typename RndIt, typename Predicate>
+    nstd::task<RndIt> async_partition_blocks(nstd::thread_pool& pool,
+                                             RndIt begin, RndIt end, Predicate predicate);
+    template <template <typename, int> class BlockManager = nstd::block_manager_relaxed,
+              typename RndIt, typename Predicate>
+    nstd::task<RndIt> async_partition(nstd::thread_pool& pool,
+                                      RndIt begin, RndIt end, Predicate predicate);
+    template <template <typename, int> class BlockManager = nstd::block_manager_relaxed,
+              typename RndIt, typename Compare>
+    nstd::task<void> async_sort(nstd::thread_pool& pool,
+                                RndIt begin, RndIt end, Compare compare);
+}
+
+// ----------------------------------------------------------------------------
+
+class nstd::task_promise_base {
+private:
+    std::coroutine_handle<> d_continuation = std::noop_coroutine();
+    std::exception_ptr      d_exception;
+
+    struct final_awaitable {
+        bool await_ready() const noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            return handle.promise().d_continuation;
+        }
+        void await_resume() const noexcept {}
+    };
+
+public:
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    final_awaitable     final_suspend() const noexcept { return {}; }
+    void unhandled_exception() { this->d_exception = std::current_exception(); }
+
+    void set_continuation(std::coroutine_handle<> continuation) {
+        this->d_continuation = continuation;
+    }
+    void rethrow() const {
+        if (this->d_exception) {
+            std::rethrow_exception(this->d_exception);
+        }
+    }
+};
+
+template <typename T>
+class nstd::task_promise
+    : public nstd::task_promise_base {
+private:
+    std::optional<T> d_value;
+
+public:
+    nstd::task<T> get_return_object();
+    template <typename V>
+    void return_value(V&& value) { this->d_value.emplace(std::forward<V>(value)); }
+    T result() {
+        this->rethrow();
+        return std::move(*this->d_value);
+    }
+};
+
+template <>
+class nstd::task_promise<void>
+    : public nstd::task_promise_base {
+public:
+    nstd::task<void> get_return_object();
+    void return_void() {}
+    void result() { this->rethrow(); }
+};
+
+// ----------------------------------------------------------------------------
+
+template <typename T>
+class nstd::task {
+public:
+    using promise_type = nstd::task_promise<T>;
+
+private:
+    std::coroutine_handle<promise_type> d_handle;
+
+public:
+    explicit task(std::coroutine_handle<promise_type> handle): d_handle(handle) {}
+    task(task&& other): d_handle(std::exchange(other.d_handle, nullptr)) {}
+    task(task&) = delete;
+    void operator=(task&) = delete;
+    ~task() {
+        if (this->d_handle) {
+            this->d_handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) {
+        this->d_handle.promise().set_continuation(continuation);
+        return this->d_handle;
+    }
+    T await_resume() { return this->d_handle.promise().result(); }
+};
+
+template <typename T>
+nstd::task<T> nstd::task_promise<T>::get_return_object() {
+    return nstd::task<T>(std::coroutine_handle<task_promise>::from_promise(*this));
+}
+
+inline nstd::task<void> nstd::task_promise<void>::get_return_object() {
+    return nstd::task<void>(std::coroutine_handle<task_promise>::from_promise(*this));
+}
+
+// ----------------------------------------------------------------------------
+// A coroutine which starts immediately and destroys itself on completion. It
+// is used to start tasks from normal functions.
+
+class nstd::detached_task {
+public:
+    struct promise_type {
+        detached_task       get_return_object() const noexcept { return {}; }
+        std::suspend_never  initial_suspend() const noexcept { return {}; }
+        std::suspend_never  final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+// ----------------------------------------------------------------------------
+// The common part of the fork/join awaitables: the counter starts out one
+// higher than the number of jobs to avoid a race between the jobs completing
+// and await_suspend() finishing. The first exception is kept and rethrown.
+
+class nstd::fork_join_state {
+private:
+    std::atomic<int>        d_count;
+    std::atomic<bool>       d_failed;
+    std::exception_ptr      d_exception;
+    std::coroutine_handle<> d_continuation;
+
+protected:
+    fork_join_state(): d_count(0), d_failed(false) {}
+    void start(std::coroutine_handle<> continuation, int count) {
+        this->d_continuation = continuation;
+        this->d_count = count + 1;
+    }
+    bool finish_start() { return 0 != --this->d_count; }
+    void fail(std::exception_ptr ex) {
+        if (!this->d_failed.exchange(true)) {
+            this->d_exception = ex;
+        }
+    }
+    void arrive() {
+        if (0 == --this->d_count) {
+            this->d_continuation.resume();
+        }
+    }
+
+public:
+    fork_join_state(fork_join_state&) = delete;
+    void operator=(fork_join_state&) = delete;
+
+    bool await_ready() const noexcept { return false; }
+    void await_resume() const {
+        if (this->d_exception) {
+            std::rethrow_exception(this->d_exception);
+        }
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+template <typename Fun>
+class nstd::bulk_awaitable
+    : public nstd::fork_join_state {
+private:
+    nstd::thread_pool& d_pool;
+    int                d_jobs;
+    Fun                d_fun;
+
+public:
+    bulk_awaitable(nstd::thread_pool& pool, int count, Fun fun)
+        : d_pool(pool)
+        , d_jobs(count)
+        , d_fun(std::move(fun)) {
+    }
+    bool await_suspend(std::coroutine_handle<> continuation) {
+        this->start(continuation, this->d_jobs);
+        this->d_pool.enqueue_bulk(this->d_jobs, [this](int i){
+                try {
+                    this->d_fun(i);
+                }
+                catch (...) {
+                    this->fail(std::current_exception());
+                }
+                this->arrive();
+            });
+        return this->finish_start();
+    }
+};
+
+template <typename Fun>
+nstd::bulk_awaitable<Fun> nstd::async_bulk(nstd::thread_pool& pool, int count, Fun fun) {
+    return nstd::bulk_awaitable<Fun>(pool, count, std::move(fun));
+}
+
+// ----------------------------------------------------------------------------
+
+class nstd::when_all_awaitable
+    : public nstd::fork_join_state {
+private:
+    nstd::thread_pool&            d_pool;
+    std::vector<nstd::task<void>> d_tasks;
+
+    static nstd::detached_task run(when_all_awaitable* self, nstd::task<void>& task) {
+        try {
+            co_await task;
+        }
+        catch (...) {
+            self->fail(std::current_exception());
+        }
+        self->arrive();
+    }
+
+public:
+    when_all_awaitable(nstd::thread_pool& pool, std::vector<nstd::task<void>> tasks)
+        : d_pool(pool)
+        , d_tasks(std::move(tasks)) {
+    }
+    bool await_suspend(std::coroutine_handle<> continuation) {
+        int count(int(this->d_tasks.size()));
+        this->start(continuation, count);
+        if (0 < count) {
+            // all but the last task are started on the pool, the last one
+            // is started immediately on the current thread
+            this->d_pool.enqueue_bulk(count - 1, [this](int i){
+                    run(this, this->d_tasks[i]);
+                });
+            run(this, this->d_tasks.back());
+        }
+        return this->finish_start();
+    }
+};
+
+inline nstd::when_all_awaitable
+nstd::when_all(nstd::thread_pool& pool, std::vector<nstd::task<void>> tasks) {
+    return nstd::when_all_awaitable(pool, std::move(tasks));
+}
+
+template <typename... Tasks>
+nstd::when_all_awaitable nstd::when_all(nstd::thread_pool& pool, Tasks... tasks) {
+    std::vector<nstd::task<void>> vector;
+    vector.reserve(sizeof...(Tasks));
+    (vector.push_back(std::move(tasks)), ...);
+    return nstd::when_all_awaitable(pool, std::move(vector));
+}
+
+// ----------------------------------------------------------------------------
+
+template <typename T>
+T nstd::sync_wait(nstd::thread_pool& pool, nstd::task<T> task) {
+    struct completion {
+        nstd::task<T>& d_task;
+        bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) {
+            return this->d_task.await_suspend(continuation);
+        }
+        void await_resume() const noexcept {}
+    };
+
+    nstd::latch latch(1);
+    [](nstd::task<T>& task, nstd::latch& latch) -> nstd::detached_task {
+        co_await completion{task};
+        latch.arrive();
+    }(task, latch);
+    pool.join(latch);
+    return task.await_resume();
+}
+
+// ----------------------------------------------------------------------------
+// Partitioning using the same jobs as nstd::parallel_partition2 but without
+// blocking the awaiting thread: the coroutine is resumed by the last job.
+
+template <template <typename, int> class BlockManager, int BlockSize,
+          typename RndIt, typename Predicate>
+nstd::task<RndIt> nstd::async_partition_blocks(nstd::thread_pool& pool,
+                                               RndIt begin, RndIt end, Predicate predicate) {
+    BlockManager<RndIt, BlockSize> bm(begin, end);
+    std::vector<std::pair<RndIt, RndIt>> leftover;
+    {
+        auto budget = pool.reserve(pool.thread_count());
+        leftover.resize(std::max(1, budget.count()));
+        co_await nstd::async_bulk(pool, int(leftover.size()), [&](int j){
+                leftover[j] = nstd::partition_blocks(bm, predicate);
+            });
+    }
+    co_return nstd::finish_partition(bm, leftover.begin(), leftover.end());
+}
+
+template <template <typename, int> class BlockManager, typename RndIt, typename Predicate>
+nstd::task<RndIt> nstd::async_partition(nstd::thread_pool& pool,
+                                        RndIt begin, RndIt end, Predicate predicate) {
+    auto tuning = nstd::tuning_for<RndIt>();
+    auto cutoff = nstd::with_block_size(tuning.block_size, [&](auto blocksize){
+            return std::ptrdiff_t(tuning.min_blocks) * decltype(blocksize)::value;
+        });
+    if (std::distance(begin, end) < cutoff) {
+        co_return std::partition(begin, end, predicate);
+    }
+    co_return co_await nstd::with_block_size(tuning.block_size, [&](auto blocksize){
+            return nstd::async_partition_blocks<BlockManager, decltype(blocksize)::value>(
+                pool, begin, end, predicate);
+        });
+}
+
+// ----------------------------------------------------------------------------
+// The coroutine version of async_sort_with(): the two halves are sorted
+// concurrently and the awaiting coroutine is resumed once both are done.
+
+template <template <typename, int> class BlockManager, typename RndIt, typename Compare>
+nstd::task<void> nstd::async_sort(nstd::thread_pool& pool,
+                                  RndIt begin, RndIt end, Compare compare) {
+    auto size = std::distance(begin, end);
+    if (size < nstd::tuning_for<RndIt>().sort_cutoff) {
+        std::sort(begin, end, compare);
+        co_return;
+    }
+
+    auto mid = begin + size / 2;
+    std::iter_swap(mid, end - 1);
+    auto partition_pred = [&compare, pivot=*(end - 1)](auto const& value) {
+        return compare(value, pivot);
+    };
+    auto partition_point = co_await nstd::async_partition<BlockManager>(pool, begin, end - 1,
+                                                                        partition_pred);
+    std::iter_swap(end - 1, partition_point);
+    co_await nstd::when_all(pool,
+                            nstd::async_sort<BlockManager>(pool, begin, partition_point, compare),
+                            nstd::async_sort<BlockManager>(pool, partition_point + 1, end, compare));
+}
+
+// ----------------------------------------------------------------------------
+
+#endif
+#endif
@@ -0,0 +1,116 @@
+// cpu_features.hpp                                                  -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#ifndef INCLUDED_CPU_FEATURES
+#define INCLUDED_CPU_FEATURES
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+// ----------------------------------------------------------------------------
+// nstd::cpu_features determines once which vector instructions the CPU
+// (and the OS) supports. The kernels with variants for different
+// instruction sets use the selected level: by default the best supported
+// one. The level can be lowered, e.g., to compare the variants, but never
+// raised above the supported level.
+
+namespace nstd {
+    enum class simd_level { scalar, avx2, avx512 };
+    char const* to_string(nstd::simd_level level);
+    bool from_string(std::string const& name, nstd::simd_level& level);
+
+    class cpu_features;
+}
+
+// ----------------------------------------------------------------------------
+
+inline char const* nstd::to_string(nstd::simd_level level) {
+    switch (level) {
+    case nstd::simd_level::scalar: return "scalar";
+    case nstd::simd_level::avx2:   return "avx2";
+    case nstd::simd_level::avx512: return "avx512";
+    }
+    return "unknown";
+}
+
+inline bool nstd::from_string(std::string const& name, nstd::simd_level& level) {
+    for (auto l: { nstd::simd_level::scalar,
+                   nstd::simd_level::avx2,
+                   nstd::simd_level::avx512 }) {
+        if (name == nstd::to_string(l)) {
+            level = l;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+
+class nstd::cpu_features {
+private:
+    nstd::simd_level              d_supported;
+    std::atomic<nstd::simd_level> d_selected;
+
+    static nstd::simd_level probe() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            return nstd::simd_level::avx512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return nstd::simd_level::avx2;
+        }
+#endif
+        return nstd::simd_level::scalar;
+    }
+
+    cpu_features()
+        : d_supported(probe())
+        , d_selected(this->d_supported) {
+    }
+
+public:
+    static cpu_features& instance() {
+        static cpu_features rc;
+        return rc;
+    }
+
+    nstd::simd_level supported() const { return this->d_supported; }
+    nstd::simd_level selected() const {
+        return this->d_selected.load(std::memory_order_relaxed);
+    }
+    // returns the level actually selected
+    nstd::simd_level select(nstd::simd_level level) {
+        level = std::min(level, this->d_supported);
+        this->d_selected.store(level, std::memory_order_relaxed);
+        return level;
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+#endif
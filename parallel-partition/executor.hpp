@@ -0,0 +1,169 @@
+// executor.hpp                                                      -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#ifndef INCLUDED_EXECUTOR
+#define INCLUDED_EXECUTOR
+
+#include "latch.hpp"
+#include <algorithm>
+#include <utility>
+
+// ----------------------------------------------------------------------------
+// The parallel algorithms accept any executor, i.e., any type which can run
+// jobs on a number of threads. An executor ex needs to provide
+//
+//   ex.enqueue_job(job)  run the nullary function object job asynchronously
+//   ex.thread_count()    the number of threads (alternatively ex.size())
+//
+// Executors may provide these operations which are used if present:
+//
+//   ex.reserve(count)               a budget of at most count threads with
+//                                   member count() (see nstd::thread_pool)
+//   ex.parallel_invoke(count, fun)  run fun(0), ..., fun(count - 1) and
+//                                   wait for their completion
+//   ex.join(latch)                  wait for the latch while running
+//                                   pending jobs
+//
+// The algorithms use the executor through the functions below which fall
+// back to a simple implementation if an optional operation is missing.
+// Both nstd::thread_pool and the ::thread_pool from slides-partition.hpp
+// are executors, i.e., one pool can be shared by all algorithms.
+
+namespace nstd {
+    template <typename Executor>
+    struct executor_traits;
+    class unreserved_budget;
+
+    template <typename Executor>
+    int thread_count(Executor& executor);
+    template <typename Executor>
+    auto reserve(Executor& executor, int count)
+        -> decltype(executor_traits<Executor>::reserve(executor, count, 0));
+    template <typename Executor, typename Fun>
+    void parallel_invoke(Executor& executor, int count, Fun&& fun);
+    template <typename Executor, typename Latch>
+    void join(Executor& executor, Latch& latch);
+}
+
+// ----------------------------------------------------------------------------
+
+class nstd::unreserved_budget {
+private:
+    int d_count;
+
+public:
+    explicit unreserved_budget(int count): d_count(count) {}
+    int count() const { return this->d_count; }
+};
+
+// ----------------------------------------------------------------------------
+// The overloads taking an int are preferred to those taking a long when the
+// executor provides the respective operation. They are templates to make
+// the detection a substitution failure rather than an error.
+
+template <typename Executor>
+struct nstd::executor_traits {
+    template <typename Ex = Executor>
+    static auto thread_count(Ex& executor, int)
+        -> decltype(int(executor.thread_count())) {
+        return int(executor.thread_count());
+    }
+    template <typename Ex = Executor>
+    static auto thread_count(Ex& executor, long)
+        -> decltype(int(executor.size())) {
+        return int(executor.size());
+    }
+
+    template <typename Ex = Executor>
+    static auto reserve(Ex& executor, int count, int)
+        -> decltype(executor.reserve(count)) {
+        return executor.reserve(count);
+    }
+    static nstd::unreserved_budget reserve(Executor& executor, int count, long) {
+        return nstd::unreserved_budget(std::min(count, nstd::thread_count(executor)));
+    }
+
+    template <typename Fun, typename Ex = Executor>
+    static auto parallel_invoke(Ex& executor, int count, Fun&& fun, int)
+        -> decltype(executor.parallel_invoke(count, std::forward<Fun>(fun))) {
+        return executor.parallel_invoke(count, std::forward<Fun>(fun));
+    }
+    template <typename Fun>
+    static void parallel_invoke(Executor& executor, int count, Fun&& fun, long) {
+        // the calling thread blocks: there needs to be a thread available
+        nstd::latch latch(count);
+        for (int i(0); i != count; ++i) {
+            executor.enqueue_job([&fun, &latch, i]{
+                    try {
+                        fun(i);
+                    }
+                    catch (...) {
+                        latch.arrive();
+                        throw;
+                    }
+                    latch.arrive();
+                });
+        }
+        latch.wait();
+    }
+
+    template <typename Latch, typename Ex = Executor>
+    static auto join(Ex& executor, Latch& latch, int)
+        -> decltype(executor.join(latch)) {
+        return executor.join(latch);
+    }
+    template <typename Latch>
+    static void join(Executor&, Latch& latch, long) {
+        latch.wait();
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+template <typename Executor>
+int nstd::thread_count(Executor& executor) {
+    return nstd::executor_traits<Executor>::thread_count(executor, 0);
+}
+
+template <typename Executor>
+auto nstd::reserve(Executor& executor, int count)
+    -> decltype(executor_traits<Executor>::reserve(executor, count, 0)) {
+    return nstd::executor_traits<Executor>::reserve(executor, count, 0);
+}
+
+template <typename Executor, typename Fun>
+void nstd::parallel_invoke(Executor& executor, int count, Fun&& fun) {
+    nstd::executor_traits<Executor>::parallel_invoke(executor, count,
+                                                     std::forward<Fun>(fun), 0);
+}
+
+template <typename Executor, typename Latch>
+void nstd::join(Executor& executor, Latch& latch) {
+    nstd::executor_traits<Executor>::join(executor, latch, 0);
+}
+
+// ----------------------------------------------------------------------------
+
+#endif
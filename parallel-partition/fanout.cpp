@@ -0,0 +1,79 @@
+// fanout.cpp                                                        -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#include "latch.hpp"
+#include "thread_pool.hpp"
+#include <chrono>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// ----------------------------------------------------------------------------
+// Measures the fan-out latency, i.e., the time it takes to get one (empty)
+// job to each worker and to join them again, using a loop of enqueue_job()
+// calls and using parallel_invoke().
+
+template <typename FanOut>
+void measure(std::string const& name, int workers, FanOut fan_out) {
+    using clock = std::chrono::steady_clock;
+    constexpr int repeat = 1000;
+
+    fan_out(); // warm-up
+    auto start = clock::now();
+    for (int i(0); i != repeat; ++i) {
+        fan_out();
+    }
+    auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+    std::cout << std::setw(30) << name << ' '
+              << "workers=" << std::setw(3) << workers << ' '
+              << std::setw(10) << time.count() / repeat << "ns"
+              << '\n' << std::flush;
+}
+
+// ----------------------------------------------------------------------------
+
+int main() {
+    try {
+        for (int workers: { 1, 2, 4, 8, 16, 32, 64, 128 }) {
+            nstd::thread_pool pool(workers, nstd::thread_pool::mode::work_stealing);
+            pool.start();
+
+            measure("enqueue_job() loop", workers, [&]{
+                    nstd::latch latch(workers);
+                    for (int j(0); j != workers; ++j) {
+                        pool.enqueue_job([&latch]{ latch.arrive(); });
+                    }
+                    pool.join(latch);
+                });
+            measure("parallel_invoke()", workers, [&]{
+                    pool.parallel_invoke(workers, [](int){});
+                });
+        }
+    }
+    catch (std::exception const& ex) {
+        std::cerr << "ERROR: " << ex.what() << '\n';
+    }
+}
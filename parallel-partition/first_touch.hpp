@@ -0,0 +1,115 @@
+// first_touch.hpp                                                   -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#ifndef INCLUDED_FIRST_TOUCH
+#define INCLUDED_FIRST_TOUCH
+
+#include "thread_pool.hpp"
+#include "topology.hpp"
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+
+// ----------------------------------------------------------------------------
+// Memory pages are placed on the NUMA node of the thread first touching
+// them. nstd::first_touch() lets the workers of a pool initialize a range
+// such that each node initializes a contiguous part of the range: with a
+// pool placed on NUMA nodes the data is spread evenly over the nodes'
+// memory. The range should not have been touched before, e.g., it should
+// be allocated using nstd::default_init_allocator which, unlike
+// std::allocator, doesn't value-initialize elements of std::vector.
+
+namespace nstd {
+    template <typename T> class default_init_allocator;
+
+    template <typename RndIt, typename Fun>
+    void first_touch(nstd::thread_pool& pool, RndIt begin, RndIt end, Fun fun);
+}
+
+// ----------------------------------------------------------------------------
+
+template <typename T>
+class nstd::default_init_allocator
+    : public std::allocator<T> {
+public:
+    template <typename O>
+    struct rebind { using other = default_init_allocator<O>; };
+
+    using std::allocator<T>::allocator;
+    default_init_allocator() = default;
+    template <typename O>
+    default_init_allocator(default_init_allocator<O> const& other) noexcept
+        : std::allocator<T>(other) {
+    }
+
+    template <typename O>
+    void construct(O* ptr) {
+        ::new(static_cast<void*>(ptr)) O;
+    }
+    template <typename O, typename... Args>
+    void construct(O* ptr, Args&&... args) {
+        ::new(static_cast<void*>(ptr)) O(std::forward<Args>(args)...);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// The range is split into one part per node. Each job repeatedly claims a
+// chunk from the part of the node it is running on, calling fun(b, e) for
+// the chunk, and helps with the other nodes' parts once its own part is
+// done.
+
+template <typename RndIt, typename Fun>
+void nstd::first_touch(nstd::thread_pool& pool, RndIt begin, RndIt end, Fun fun) {
+    using difference_type = typename std::iterator_traits<RndIt>::difference_type;
+    struct part {
+        std::atomic<difference_type> next;
+        difference_type              end;
+    };
+    difference_type const chunk(1 << 16);
+    difference_type const size(std::distance(begin, end));
+    int const             nodes(nstd::cpu_topology::instance().node_count());
+
+    std::unique_ptr<part[]> parts(new part[nodes]);
+    for (int node(0); node != nodes; ++node) {
+        parts[node].next = size * node / nodes;
+        parts[node].end  = size * (node + 1) / nodes;
+    }
+    pool.parallel_invoke(pool.thread_count(), [&](int){
+            int home(std::min(std::max(0, pool.current_node()), nodes - 1));
+            for (int i(0); i != nodes; ++i) {
+                part& p(parts[(home + i) % nodes]);
+                for (difference_type b; (b = p.next.fetch_add(chunk)) < p.end; ) {
+                    fun(begin + b, begin + std::min(b + chunk, p.end));
+                }
+            }
+        });
+}
+
+// ----------------------------------------------------------------------------
+
+#endif
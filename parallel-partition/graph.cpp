@@ -0,0 +1,167 @@
+// graph.cpp                                                         -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#include "task_graph.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Runs a pipeline partitioning chunks of unevenly sized input by a key,
+// sorting each side of each chunk, merging all sides, and removing
+// duplicates once with a latch between the stages and once as a task graph
+// where each step only waits for the data it uses.
+
+struct pipeline {
+    std::vector<std::vector<int>> chunks;
+    std::vector<std::vector<int>::iterator> middles;
+    std::vector<int> sides[2];
+    int key;
+
+    pipeline(std::vector<std::vector<int>> const& input, int key)
+        : chunks(input), middles(input.size()), key(key) {}
+
+    void partition(int c) {
+        int k(this->key);
+        this->middles[c] = std::partition(this->chunks[c].begin(), this->chunks[c].end(),
+                                          [k](int value){ return value < k; });
+    }
+    void sort(int c, int side) {
+        auto& chunk(this->chunks[c]);
+        if (side == 0) {
+            std::sort(chunk.begin(), this->middles[c]);
+        }
+        else {
+            std::sort(this->middles[c], chunk.end());
+        }
+    }
+    void merge(int side) {
+        std::vector<int> result, tmp;
+        for (std::size_t c(0); c != this->chunks.size(); ++c) {
+            auto& chunk(this->chunks[c]);
+            auto  begin(side == 0? chunk.begin(): this->middles[c]);
+            auto  end(side == 0? this->middles[c]: chunk.end());
+            tmp.clear();
+            std::merge(result.begin(), result.end(), begin, end, std::back_inserter(tmp));
+            result.swap(tmp);
+        }
+        this->sides[side].swap(result);
+    }
+    void dedup(int side) {
+        auto& v(this->sides[side]);
+        v.erase(std::unique(v.begin(), v.end()), v.end());
+    }
+    std::vector<int> result() const {
+        std::vector<int> rc(this->sides[0]);
+        rc.insert(rc.end(), this->sides[1].begin(), this->sides[1].end());
+        return rc;
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+template <typename Run>
+void measure(std::string const& name, int workers,
+             std::vector<std::vector<int>> const& input, std::vector<int> const& expect,
+             Run run) {
+    using clock = std::chrono::steady_clock;
+    constexpr int repeat = 10;
+
+    clock::duration time{};
+    bool            ok(true);
+    for (int i(0); i != repeat; ++i) {
+        pipeline p(input, 50000);
+        auto start = clock::now();
+        run(p);
+        time += clock::now() - start;
+        ok = ok && p.result() == expect;
+    }
+    std::cout << std::setw(20) << name << ' '
+              << "workers=" << std::setw(3) << workers << ' '
+              << (ok? "passed": "\x1b[31mfailed\x1b[0m") << ' '
+              << std::setw(8)
+              << std::chrono::duration_cast<std::chrono::microseconds>(time).count() / repeat << "us"
+              << '\n' << std::flush;
+}
+
+// ----------------------------------------------------------------------------
+
+int main() {
+    try {
+        constexpr int chunks = 32;
+        std::minstd_rand rnd(0);
+        std::vector<std::vector<int>> input(chunks);
+        for (int c(0); c != chunks; ++c) {
+            std::generate_n(std::back_inserter(input[c]), 4000 * (1 + c % 8),
+                            [&rnd]{ return rnd() % 100000; });
+        }
+        std::vector<int> expect;
+        for (auto const& chunk: input) {
+            expect.insert(expect.end(), chunk.begin(), chunk.end());
+        }
+        std::sort(expect.begin(), expect.end());
+        expect.erase(std::unique(expect.begin(), expect.end()), expect.end());
+
+        for (int workers: { 1, 2, 4, 8, 16 }) {
+            nstd::thread_pool pool(workers, nstd::thread_pool::mode::work_stealing);
+            pool.start();
+
+            measure("stages", workers, input, expect, [&](pipeline& p){
+                    pool.parallel_invoke(chunks, [&](int c){ p.partition(c); });
+                    pool.parallel_invoke(2 * chunks, [&](int i){ p.sort(i / 2, i % 2); });
+                    pool.parallel_invoke(2, [&](int side){ p.merge(side); });
+                    pool.parallel_invoke(2, [&](int side){ p.dedup(side); });
+                });
+            measure("task_graph", workers, input, expect, [&](pipeline& p){
+                    nstd::task_graph graph;
+                    nstd::task_graph::handle merge[2] = {
+                        graph.emplace([&p]{ p.merge(0); }),
+                        graph.emplace([&p]{ p.merge(1); })
+                    };
+                    for (int c(0); c != chunks; ++c) {
+                        auto partition(graph.emplace([&p, c]{ p.partition(c); }));
+                        for (int side: { 0, 1 }) {
+                            auto sort(graph.emplace([&p, c, side]{ p.sort(c, side); }, partition));
+                            graph.precede(sort, merge[side]);
+                        }
+                    }
+                    graph.emplace([&p]{ p.dedup(0); }, merge[0]);
+                    graph.emplace([&p]{ p.dedup(1); }, merge[1]);
+                    graph.run(pool);
+                });
+        }
+    }
+    catch (std::exception const& ex) {
+        std::cerr << "ERROR: " << ex.what() << '\n';
+    }
+}
@@ -0,0 +1,73 @@
+// idle_policy.hpp                                                   -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#ifndef INCLUDED_IDLE_POLICY
+#define INCLUDED_IDLE_POLICY
+
+// ----------------------------------------------------------------------------
+// An nstd::idle_policy determines what an idle worker of nstd::thread_pool
+// does before going to sleep on the condition variable: it first checks for
+// new jobs `spins` times, pausing the CPU in between, then `yields` times,
+// yielding its time slice in between. Spinning avoids the cost of a futex
+// wake-up when jobs arrive shortly after the worker ran out of work but it
+// keeps the CPU busy.
+
+namespace nstd {
+    struct idle_policy;
+    void cpu_relax();
+}
+
+// ----------------------------------------------------------------------------
+
+struct nstd::idle_policy {
+    int spins;
+    int yields;
+
+    constexpr idle_policy(int spins = 0, int yields = 0)
+        : spins(spins)
+        , yields(yields) {
+    }
+
+    // go to sleep immediately: no CPU is burnt but the wake-up is slow
+    static constexpr idle_policy park() { return idle_policy(0, 0); }
+    // bridge short gaps between jobs, e.g., between partition phases
+    static constexpr idle_policy spin_then_park() { return idle_policy(2000, 20); }
+    // spin for a long time (milliseconds) before sleeping
+    static constexpr idle_policy low_latency() { return idle_policy(200000, 2000); }
+};
+
+// ----------------------------------------------------------------------------
+
+inline void nstd::cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+#endif
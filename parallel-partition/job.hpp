@@ -0,0 +1,152 @@
+// job.hpp                                                           -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#ifndef INCLUDED_JOB
+#define INCLUDED_JOB
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// ----------------------------------------------------------------------------
+// nstd::job is a move-only replacement for std::function<void()> used for
+// the jobs of nstd::thread_pool: function objects up to job::capacity bytes
+// are stored inline, i.e., creating a job for them never allocates. Larger
+// function objects are still supported but are put on the heap.
+
+namespace nstd {
+    class job;
+}
+
+// ----------------------------------------------------------------------------
+
+class nstd::job {
+public:
+    static constexpr std::size_t capacity = 6 * sizeof(void*);
+
+private:
+    struct operations {
+        void (*call)(void*);
+        void (*move)(void*, void*);
+        void (*destroy)(void*);
+    };
+
+    template <typename Fun>
+    struct inline_operations {
+        static void call(void* fun) { (*static_cast<Fun*>(fun))(); }
+        static void move(void* to, void* from) {
+            new(to) Fun(std::move(*static_cast<Fun*>(from)));
+            static_cast<Fun*>(from)->~Fun();
+        }
+        static void destroy(void* fun) { static_cast<Fun*>(fun)->~Fun(); }
+        static constexpr operations ops{ &call, &move, &destroy };
+    };
+    template <typename Fun>
+    struct heap_operations {
+        static Fun*& get(void* fun) { return *static_cast<Fun**>(fun); }
+        static void call(void* fun) { (*get(fun))(); }
+        static void move(void* to, void* from) {
+            new(to) Fun*(get(from));
+        }
+        static void destroy(void* fun) { delete get(fun); }
+        static constexpr operations ops{ &call, &move, &destroy };
+    };
+    template <typename Fun>
+    using operations_for = typename std::conditional<
+        sizeof(Fun) <= capacity
+        && alignof(Fun) <= alignof(std::max_align_t)
+        && std::is_nothrow_move_constructible<Fun>::value,
+        inline_operations<Fun>,
+        heap_operations<Fun>>::type;
+
+    alignas(std::max_align_t) unsigned char d_storage[capacity];
+    operations const*                       d_ops;
+
+    template <typename Fun>
+    void construct(Fun&& fun, inline_operations<typename std::decay<Fun>::type>*) {
+        new(this->d_storage) typename std::decay<Fun>::type(std::forward<Fun>(fun));
+    }
+    template <typename Fun>
+    void construct(Fun&& fun, heap_operations<typename std::decay<Fun>::type>*) {
+        new(this->d_storage) typename std::decay<Fun>::type*(
+            new typename std::decay<Fun>::type(std::forward<Fun>(fun)));
+    }
+
+public:
+    job(): d_ops(nullptr) {}
+    template <typename Fun,
+              typename = typename std::enable_if<
+                  !std::is_same<typename std::decay<Fun>::type, job>::value>::type>
+    job(Fun&& fun)
+        : d_ops(nullptr) {
+        this->emplace(std::forward<Fun>(fun));
+    }
+    job(job&& other)
+        : d_ops(other.d_ops) {
+        if (this->d_ops) {
+            this->d_ops->move(this->d_storage, other.d_storage);
+            other.d_ops = nullptr;
+        }
+    }
+    job& operator=(job&& other) {
+        if (this != &other) {
+            this->reset();
+            if (other.d_ops) {
+                other.d_ops->move(this->d_storage, other.d_storage);
+                std::swap(this->d_ops, other.d_ops);
+            }
+        }
+        return *this;
+    }
+    job(job const&) = delete;
+    void operator=(job const&) = delete;
+    ~job() { this->reset(); }
+
+    template <typename Fun>
+    void emplace(Fun&& fun) {
+        using ops_t = operations_for<typename std::decay<Fun>::type>;
+        this->reset();
+        this->construct(std::forward<Fun>(fun), static_cast<ops_t*>(nullptr));
+        this->d_ops = &ops_t::ops;
+    }
+    void reset() {
+        if (this->d_ops) {
+            this->d_ops->destroy(this->d_storage);
+            this->d_ops = nullptr;
+        }
+    }
+    explicit operator bool() const { return this->d_ops != nullptr; }
+    void operator()() { this->d_ops->call(this->d_storage); }
+};
+
+template <typename Fun>
+constexpr nstd::job::operations nstd::job::inline_operations<Fun>::ops;
+template <typename Fun>
+constexpr nstd::job::operations nstd::job::heap_operations<Fun>::ops;
+
+// ----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,244 @@
+// job_list.hpp                                                      -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#ifndef INCLUDED_JOB_LIST
+#define INCLUDED_JOB_LIST
+
+#include "job.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+// ----------------------------------------------------------------------------
+// The queues of nstd::thread_pool are intrusive lists of job_nodes. The
+// nodes are obtained from a job_slab which allocates them in chunks and
+// keeps released nodes for reuse: once the slab has grown to the number of
+// concurrently queued jobs enqueuing a job doesn't allocate any memory.
+//
+// The free nodes of the slab are kept in a lock-free stack, i.e., threads
+// without a cache of nodes (e.g., external producers submitting to a pool)
+// don't serialise on a mutex. The stack's head names the top node by its
+// index together with a tag changed on every update to avoid ABA problems:
+// the chunks double in size which makes the nodes easy to number.
+
+namespace nstd {
+    struct job_node;
+    class job_list;
+    class job_slab;
+}
+
+// ----------------------------------------------------------------------------
+
+struct nstd::job_node {
+    job_node*                  d_next;
+    job_node*                  d_prev;
+    nstd::job                  d_job;
+    std::uint32_t              d_index;     // set by the job_slab
+    std::atomic<std::uint32_t> d_free_next; // index + 1 in the job_slab's stack
+};
+
+// ----------------------------------------------------------------------------
+
+class nstd::job_list {
+private:
+    job_node*   d_head;
+    job_node*   d_tail;
+    std::size_t d_size;
+
+public:
+    job_list(): d_head(nullptr), d_tail(nullptr), d_size(0u) {}
+    job_list(job_list&) = delete;
+    void operator=(job_list&) = delete;
+
+    bool        empty() const { return this->d_head == nullptr; }
+    std::size_t size() const  { return this->d_size; }
+
+    void push_back(job_node* node) {
+        node->d_next = nullptr;
+        node->d_prev = this->d_tail;
+        (this->d_tail? this->d_tail->d_next: this->d_head) = node;
+        this->d_tail = node;
+        ++this->d_size;
+    }
+    void push_front(job_node* node) {
+        node->d_prev = nullptr;
+        node->d_next = this->d_head;
+        (this->d_head? this->d_head->d_prev: this->d_tail) = node;
+        this->d_head = node;
+        ++this->d_size;
+    }
+    job_node* pop_front() {
+        job_node* node(this->d_head);
+        if (node) {
+            this->d_head = node->d_next;
+            (this->d_head? this->d_head->d_prev: this->d_tail) = nullptr;
+            --this->d_size;
+        }
+        return node;
+    }
+    job_node* pop_back() {
+        job_node* node(this->d_tail);
+        if (node) {
+            this->d_tail = node->d_prev;
+            (this->d_tail? this->d_tail->d_next: this->d_head) = nullptr;
+            --this->d_size;
+        }
+        return node;
+    }
+    void splice(job_list& other) {
+        if (other.empty()) {
+            return;
+        }
+        other.d_head->d_prev = this->d_tail;
+        (this->d_tail? this->d_tail->d_next: this->d_head) = other.d_head;
+        this->d_tail = other.d_tail;
+        this->d_size += other.d_size;
+        other.d_head = other.d_tail = nullptr;
+        other.d_size = 0u;
+    }
+    void splice(job_list& other, std::size_t count) {
+        while (count-- && !other.empty()) {
+            this->push_back(other.pop_front());
+        }
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+class nstd::job_slab {
+private:
+    // chunk k holds first_chunk << k nodes: up to 2^32 - first_chunk nodes
+    static constexpr std::uint32_t first_chunk = 256u;
+    static constexpr int           max_chunks  = 24;
+
+    std::mutex                 d_mutex; // only serialises growing the slab
+    std::atomic<job_node*>     d_chunks[max_chunks];
+    int                        d_chunk_count;
+    std::atomic<std::uint64_t> d_free; // tag << 32 | (index + 1), 0 if empty
+
+    static std::uint64_t next(std::uint64_t head, std::uint32_t top) {
+        return ((head >> 32) + 1u) << 32 | top;
+    }
+    job_node* node(std::uint32_t index) const {
+        int chunk(0);
+        for (std::uint32_t q(index / first_chunk + 1u); q >>= 1; ) {
+            ++chunk;
+        }
+        std::uint32_t offset(index - first_chunk * ((1u << chunk) - 1u));
+        return this->d_chunks[chunk].load(std::memory_order_acquire) + offset;
+    }
+    // push the nodes first ... last which are already linked by d_free_next
+    void push(job_node* first, job_node* last) {
+        std::uint64_t head(this->d_free.load(std::memory_order_relaxed));
+        do {
+            last->d_free_next.store(std::uint32_t(head), std::memory_order_relaxed);
+        }
+        while (!this->d_free.compare_exchange_weak(head, next(head, first->d_index + 1u),
+                                                   std::memory_order_release,
+                                                   std::memory_order_relaxed));
+    }
+    job_node* pop() {
+        std::uint64_t head(this->d_free.load(std::memory_order_acquire));
+        job_node*     rc;
+        do {
+            if (0u == std::uint32_t(head)) {
+                return nullptr;
+            }
+            // the node may be popped concurrently but nodes are never freed
+            rc = this->node(std::uint32_t(head) - 1u);
+        }
+        while (!this->d_free.compare_exchange_weak(head,
+                                                   next(head, rc->d_free_next.load(std::memory_order_relaxed)),
+                                                   std::memory_order_acquire,
+                                                   std::memory_order_acquire));
+        return rc;
+    }
+    void grow() {
+        std::lock_guard<std::mutex> kerberos(this->d_mutex);
+        if (0u != std::uint32_t(this->d_free.load(std::memory_order_acquire))) {
+            return; // another thread grew the slab meanwhile
+        }
+        if (this->d_chunk_count == max_chunks) {
+            throw std::bad_alloc();
+        }
+        int           chunk(this->d_chunk_count++);
+        std::uint32_t size(first_chunk << chunk);
+        std::uint32_t index(first_chunk * ((1u << chunk) - 1u));
+        job_node*     nodes(new job_node[size]);
+        for (std::uint32_t i(0); i != size; ++i) {
+            nodes[i].d_index = index + i;
+            nodes[i].d_free_next.store(index + i + 2u, std::memory_order_relaxed);
+        }
+        this->d_chunks[chunk].store(nodes, std::memory_order_release);
+        this->push(nodes, nodes + size - 1);
+    }
+
+public:
+    job_slab(): d_chunk_count(0), d_free(0u) {
+        for (auto& chunk: this->d_chunks) {
+            chunk.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+    job_slab(job_slab&) = delete;
+    void operator=(job_slab&) = delete;
+    ~job_slab() {
+        for (int chunk(0); chunk != this->d_chunk_count; ++chunk) {
+            delete[] this->d_chunks[chunk].load(std::memory_order_relaxed);
+        }
+    }
+
+    job_node* allocate() {
+        job_node* rc;
+        while (!(rc = this->pop())) {
+            this->grow();
+        }
+        return rc;
+    }
+    void release(job_node* node) {
+        this->push(node, node);
+    }
+    void refill(job_list& cache, std::size_t count) {
+        while (count--) {
+            cache.push_back(this->allocate());
+        }
+    }
+    void drain(job_list& cache, std::size_t count) {
+        job_node* first(count? cache.pop_front(): nullptr);
+        if (!first) {
+            return;
+        }
+        job_node* last(first);
+        for (job_node* node; --count && (node = cache.pop_front()); last = node) {
+            last->d_free_next.store(node->d_index + 1u, std::memory_order_relaxed);
+        }
+        this->push(first, last);
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,209 @@
+// job_queue.hpp                                                     -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#ifndef INCLUDED_JOB_QUEUE
+#define INCLUDED_JOB_QUEUE
+
+#include "job_list.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+// ----------------------------------------------------------------------------
+// The shared queue of nstd::basic_thread_pool is a template parameter. A
+// queue provides push(job_list&) taking all nodes of the list, pop()
+// returning the next node or a null pointer, and an approximate size().
+//
+// - locked_job_queue is a job_list protected by a mutex.
+// - mpmc_job_queue is a bounded lock-free ring buffer following Dmitry
+//   Vyukov's MPMC queue: each cell carries a sequence number telling
+//   producers and consumers whether it is their turn. When the ring is full
+//   nodes go to a locked overflow list instead of failing; consumers move
+//   them back into the ring as space becomes available.
+
+namespace nstd {
+    class locked_job_queue;
+    template <std::size_t Capacity = 1024u>
+    class mpmc_job_queue;
+}
+
+// ----------------------------------------------------------------------------
+
+class nstd::locked_job_queue {
+private:
+    std::mutex     d_mutex;
+    nstd::job_list d_jobs;
+
+public:
+    locked_job_queue() = default;
+    locked_job_queue(locked_job_queue&) = delete;
+    void operator=(locked_job_queue&) = delete;
+
+    void push(nstd::job_list& nodes) {
+        std::lock_guard<std::mutex> kerberos(this->d_mutex);
+        this->d_jobs.splice(nodes);
+    }
+    nstd::job_node* pop() {
+        std::lock_guard<std::mutex> kerberos(this->d_mutex);
+        return this->d_jobs.pop_front();
+    }
+    std::size_t size() {
+        std::lock_guard<std::mutex> kerberos(this->d_mutex);
+        return this->d_jobs.size();
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+template <std::size_t Capacity>
+class nstd::mpmc_job_queue {
+private:
+    static_assert(Capacity && !(Capacity & (Capacity - 1u)),
+                  "the capacity of mpmc_job_queue has to be a power of 2");
+    static constexpr std::size_t mask = Capacity - 1u;
+
+    struct cell {
+        std::atomic<std::size_t> d_sequence;
+        nstd::job_node*          d_node;
+    };
+
+    char                     d_padding0[64]; // avoid false sharing
+    std::atomic<std::size_t> d_head;
+    char                     d_padding1[64];
+    std::atomic<std::size_t> d_tail;
+    char                     d_padding2[64];
+    std::unique_ptr<cell[]>  d_cells;
+    std::atomic<std::size_t> d_overflow_count;
+    std::mutex               d_mutex;
+    nstd::job_list           d_overflow;
+
+    bool try_push(nstd::job_node* node) {
+        std::size_t pos(this->d_tail.load(std::memory_order_relaxed));
+        cell*       c;
+        while (true) {
+            c = &this->d_cells[pos & mask];
+            std::size_t    sequence(c->d_sequence.load(std::memory_order_acquire));
+            std::intptr_t  diff(std::intptr_t(sequence) - std::intptr_t(pos));
+            if (diff == 0) {
+                if (this->d_tail.compare_exchange_weak(pos, pos + 1u,
+                                                       std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                return false; // full
+            }
+            else {
+                pos = this->d_tail.load(std::memory_order_relaxed);
+            }
+        }
+        c->d_node = node;
+        c->d_sequence.store(pos + 1u, std::memory_order_release);
+        return true;
+    }
+    nstd::job_node* try_pop() {
+        std::size_t pos(this->d_head.load(std::memory_order_relaxed));
+        cell*       c;
+        while (true) {
+            c = &this->d_cells[pos & mask];
+            std::size_t   sequence(c->d_sequence.load(std::memory_order_acquire));
+            std::intptr_t diff(std::intptr_t(sequence) - std::intptr_t(pos + 1u));
+            if (diff == 0) {
+                if (this->d_head.compare_exchange_weak(pos, pos + 1u,
+                                                       std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                return nullptr; // empty
+            }
+            else {
+                pos = this->d_head.load(std::memory_order_relaxed);
+            }
+        }
+        nstd::job_node* node(c->d_node);
+        c->d_sequence.store(pos + mask + 1u, std::memory_order_release);
+        return node;
+    }
+
+public:
+    mpmc_job_queue()
+        : d_head(0u)
+        , d_tail(0u)
+        , d_cells(new cell[Capacity])
+        , d_overflow_count(0u) {
+        for (std::size_t i(0); i != Capacity; ++i) {
+            this->d_cells[i].d_sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    mpmc_job_queue(mpmc_job_queue&) = delete;
+    void operator=(mpmc_job_queue&) = delete;
+
+    void push(nstd::job_list& nodes) {
+        while (!nodes.empty()) {
+            // once nodes overflow, new nodes queue up behind them
+            if (0u == this->d_overflow_count.load(std::memory_order_relaxed)) {
+                nstd::job_node* node(nodes.pop_front());
+                if (this->try_push(node)) {
+                    continue;
+                }
+                nodes.push_front(node);
+            }
+            std::lock_guard<std::mutex> kerberos(this->d_mutex);
+            this->d_overflow.splice(nodes);
+            this->d_overflow_count = this->d_overflow.size();
+        }
+    }
+    nstd::job_node* pop() {
+        nstd::job_node* node(this->try_pop());
+        if (0u != this->d_overflow_count.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> kerberos(this->d_mutex);
+            if (!node) {
+                node = this->d_overflow.pop_front();
+            }
+            // move overflowing nodes into the space which became available
+            nstd::job_node* next;
+            while ((next = this->d_overflow.pop_front()) && this->try_push(next)) {
+            }
+            if (next) {
+                this->d_overflow.push_front(next);
+            }
+            this->d_overflow_count = this->d_overflow.size();
+        }
+        return node;
+    }
+    std::size_t size() {
+        std::size_t tail(this->d_tail.load(std::memory_order_relaxed));
+        std::size_t head(this->d_head.load(std::memory_order_relaxed));
+        return (head < tail? tail - head: 0u)
+            + this->d_overflow_count.load(std::memory_order_relaxed);
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,102 @@
+// large.cpp                                                         -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#include "slides-partition.hpp"
+#include "parallel_partition.hpp"
+#include "first_touch.hpp"
+#include "timer.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Partitions ranges with more elements than fit into an int (by default
+// 5e9 one byte elements) and checks the result. The data is regenerated
+// for each algorithm, i.e., only one copy needs to fit into memory. The
+// size can be given as argument.
+
+using container = std::vector<unsigned char, nstd::default_init_allocator<unsigned char>>;
+
+void generate(nstd::thread_pool& pool, container& v) {
+    nstd::first_touch(pool, v.begin(), v.end(), [&v](auto b, auto e){
+            std::minstd_rand rnd(unsigned(b - v.begin()));
+            std::generate(b, e, [&rnd]{ return static_cast<unsigned char>(rnd()); });
+        });
+}
+
+template <typename Partition>
+void test(nstd::thread_pool& pool, std::string const& name, container& v, Partition partition) {
+    auto predicate([](unsigned char value){ return value < 128u; });
+    generate(pool, v);
+    utility::timer timer;
+    timer.start();
+    auto it   = partition(v.begin(), v.end(), predicate);
+    auto time = timer.stop();
+    bool rc   = std::is_partitioned(v.begin(), v.end(), predicate)
+        && it == std::partition_point(v.begin(), v.end(), predicate)
+        ;
+    std::cout << std::setw(55) << name << ' '
+              << "size=" << v.size() << ' '
+              << (rc? "passed": "\x1b[31mfailed\x1b[0m") << ' '
+              << time << '\n' << std::flush;
+}
+
+// ----------------------------------------------------------------------------
+
+int main(int ac, char* av[]) {
+    try {
+        unsigned long long size(ac == 1? 5000000000ull: std::strtoull(av[1], nullptr, 10));
+        nstd::thread_pool& pool(nstd::default_pool());
+        container v(size);
+
+        test(pool, "blocked(pool)", v, [&pool](auto begin, auto end, auto pred) {
+                return blocked(pool, begin, end, pred);
+            });
+        test(pool, "parallel_partition2<nstd::block_manager>", v,
+             nstd::parallel_partition2<nstd::block_manager>(pool));
+        test(pool, "parallel_partition2<nstd::block_manager_atomic>", v,
+             nstd::parallel_partition2<nstd::block_manager_atomic>(pool));
+        test(pool, "parallel_partition2<nstd::block_manager_padded_atomic>", v,
+             nstd::parallel_partition2<nstd::block_manager_padded_atomic>(pool));
+        test(pool, "parallel_partition2<nstd::block_manager_relaxed>", v,
+             nstd::parallel_partition2<nstd::block_manager_relaxed>(pool));
+        test(pool, "parallel_partition2<nstd::block_manager_guided>", v,
+             nstd::parallel_partition2<nstd::block_manager_guided>(pool));
+        test(pool, "parallel_partition2<nstd::block_manager_packed>", v,
+             nstd::parallel_partition2<nstd::block_manager_packed>(pool));
+        test(pool, "parallel_partition2<nstd::block_manager_numa>", v,
+             nstd::parallel_partition2<nstd::block_manager_numa>(pool));
+        test(pool, "parallel_partition3<nstd::block_manager_relaxed>", v,
+             nstd::parallel_partition3<nstd::block_manager_relaxed>(pool));
+    }
+    catch (std::exception const& ex) {
+        std::cerr << "ERROR: " << ex.what() << '\n';
+    }
+}
@@ -26,10 +26,19 @@
 #ifndef INCLUDED_LATCH
 #define INCLUDED_LATCH
 
-#include <condition_variable>
-#include <mutex>
+#include "atomic_wait.hpp"
+#include "idle_policy.hpp"
+#include <atomic>
 
 // ----------------------------------------------------------------------------
+// The state of the latch combines the count (the upper bits) and a flag
+// indicating that a thread is blocked (the lowest bit): arrive() is a
+// single atomic decrement and only the last arrival wakes blocked threads,
+// if there are any. As with std::latch, the last arrival still notifies
+// the blocked threads after its decrement released them, i.e., a released
+// waiter may return before arrive() did. Destroying a latch right after
+// wait() returned relies on the notification tolerating that (as a futex
+// and std::atomic's notify_all() do).
 
 namespace nstd {
     class latch;
@@ -39,21 +48,42 @@ namespace nstd {
 
 class nstd::latch {
 private:
-    std::mutex              d_mutex;
-    std::condition_variable d_condition;
-    int                     d_await;
+    static constexpr int spins = 128;
+
+    std::atomic<int> d_state;
 
 public:
-    explicit latch(int await): d_await(await) {}
+    explicit latch(int await): d_state(2 * await) {}
+    latch(latch&) = delete;
+    void operator=(latch&) = delete;
+
     void arrive() {
-        std::lock_guard<std::mutex> kerberos(this->d_mutex);
-        if (!--this->d_await) {
-            this->d_condition.notify_one();
+        int state(this->d_state.fetch_sub(2, std::memory_order_acq_rel));
+        if (state == 3) {
+            nstd::atomic_notify_all(this->d_state);
         }
     }
+    bool try_wait() const {
+        return this->d_state.load(std::memory_order_acquire) < 2;
+    }
     void wait() {
-        std::unique_lock<std::mutex> kerberos(this->d_mutex);
-        this->d_condition.wait(kerberos, [this]{return !this->d_await; });
+        for (int i(0); i != spins; ++i) {
+            if (this->try_wait()) {
+                return;
+            }
+            nstd::cpu_relax();
+        }
+        int state(this->d_state.load(std::memory_order_acquire));
+        while (2 <= state) {
+            if ((state & 1) || this->d_state.compare_exchange_weak(state, state | 1)) {
+                nstd::atomic_wait(this->d_state, state | 1);
+                state = this->d_state.load(std::memory_order_acquire);
+            }
+        }
+    }
+    void arrive_and_wait() {
+        this->arrive();
+        this->wait();
     }
 };
 
@@ -27,24 +27,56 @@
 #define INCLUDED_PARALLEL_PARTITION
 
 #include "not_fn.hpp"
-#include "latch.hpp"
+#include "executor.hpp"
 #include "thread_pool.hpp"
 #include "block_manager.hpp"
+#include "partition_kernel.hpp"
+#include "scratch.hpp"
+#include "tuning.hpp"
 #include <algorithm>
+#include <cstddef>
 #include <iostream>
 #include <iterator>
 #include <mutex>
 #include <thread>
+#include <utility>
+#include <vector>
 
 // ----------------------------------------------------------------------------
 
 namespace nstd {
-    template <template <typename, int> class BlockManager>
+    template <template <typename, int> class BlockManager,
+              typename Executor = nstd::thread_pool,
+              typename Kernel = nstd::branching_kernel>
     class parallel_partition;
-    template <template <typename, int> class BlockManager>
+    template <template <typename, int> class BlockManager,
+              typename Executor = nstd::thread_pool,
+              typename Kernel = nstd::branching_kernel>
     class parallel_partition2;
-    template <template <typename, int> class BlockManager>
+    template <template <typename, int> class BlockManager,
+              typename Executor = nstd::thread_pool,
+              typename Kernel = nstd::branching_kernel>
     class parallel_partition3;
+    template <typename Executor = nstd::thread_pool>
+    class tuned_partition;
+
+    template <typename BlockManager, typename Predicate>
+    auto partition_blocks(BlockManager& bm, Predicate predicate)
+        -> decltype(bm.pop_front());
+    template <typename BlockManager, typename Predicate>
+    auto partition_blocks(BlockManager& bm, Predicate predicate, nstd::branching_kernel)
+        -> decltype(bm.pop_front());
+    template <typename BlockManager, typename Predicate, typename Kernel>
+    auto partition_blocks(BlockManager& bm, Predicate predicate, Kernel kernel)
+        -> decltype(bm.pop_front());
+    template <typename RndIt, typename PairIt>
+    RndIt merge_leftovers(RndIt midpoint, PairIt begin, PairIt end);
+    template <typename BlockManager, typename PairIt>
+    auto finish_partition(BlockManager& bm, PairIt begin, PairIt end)
+        -> decltype(bm.midpoint());
+    template <typename BlockManager, typename PairIt>
+    auto finish_partition(BlockManager& bm, PairIt begin, PairIt end)
+        -> decltype(bm.midpoint(0));
 }
 
 // ----------------------------------------------------------------------------
@@ -59,11 +91,15 @@ struct parallel_partition_context {
     difference_type d_block_size;
 
     parallel_partition_context(RndIt begin, RndIt end)
+        : parallel_partition_context(begin, end, nstd::tuning_for<RndIt>()) {
+    }
+    parallel_partition_context(RndIt begin, RndIt end, nstd::tuning_parameters const& tuning)
         : d_begin(begin)
         , d_end(end)
-        , d_block_size(std::max(difference_type(128),
+        , d_block_size(std::max(difference_type(tuning.context_min_block),
                                 std::distance(begin, end)
-                                / (8 * std::thread::hardware_concurrency()))) {
+                                / (std::max(1, tuning.context_blocks_per_thread)
+                                   * int(std::max(1u, std::thread::hardware_concurrency()))))) {
     }
     
     std::pair<RndIt, RndIt> pop_front() {
@@ -82,20 +118,8 @@ struct parallel_partition_context {
     }
 };
 
-template <typename RndIt, typename Predicate>
-std::pair<RndIt, RndIt> block_partition(RndIt fit, RndIt fend,
-                                        RndIt bit, RndIt bend,
-                                        Predicate predicate) {
-    while (true) {
-        while (fit != fend &&  predicate(*fit)) { ++fit; }
-        while (bit != bend && !predicate(*bit)) { ++bit; }
-        if (fit == fend || bit == bend) { return std::make_pair(fit, bit); }
-        std::iter_swap(fit, bit);
-    }
-}
-
-template <typename RndIt, typename Predicate>
-RndIt blocked_partition(RndIt begin, RndIt end, Predicate pred) {
+template <typename RndIt, typename Predicate, typename Kernel = nstd::branching_kernel>
+RndIt blocked_partition(RndIt begin, RndIt end, Predicate pred, Kernel kernel = Kernel()) {
     parallel_partition_context<RndIt> context(begin, end);
     std::pair<RndIt, RndIt> front(begin, begin), back(end, end);
     auto bbeg(end);
@@ -116,202 +140,295 @@ RndIt blocked_partition(RndIt begin, RndIt end, Predicate pred) {
                 return std::partition(front.first, front.second, pred);
             }
         }
-        std::tie(front.first, back.first) = block_partition(front.first, front.second,
-                                                            back.first, back.second, pred);
+        std::tie(front.first, back.first) = kernel(front.first, front.second,
+                                                   back.first, back.second, pred);
     }
     return begin;
 }
 
+// ----------------------------------------------------------------------------
+// The body of one partitioning job: blocks are taken from both ends of the
+// block manager and elements are swapped between them until the block
+// manager runs out of blocks. The result is the range of the remaining block
+// which is partitioned but not yet in place.
+
+template <typename BlockManager, typename Predicate>
+auto nstd::partition_blocks(BlockManager& bm, Predicate predicate)
+    -> decltype(bm.pop_front()) {
+    auto front = bm.pop_front();
+    auto back  = bm.pop_back();
+    auto fit   = front.first;
+    auto bit   = back.first;
+    while (true) {
+        while (front.second == (fit = std::find_if(fit, front.second, nstd::not_fn(predicate)))) {
+            front = bm.pop_front();
+            fit   = front.first;
+            if (front.first == front.second){
+                auto it = std::partition(back.first, back.second, predicate);
+                return std::make_pair(back.first, it);
+            }
+        }
+        while (back.second == (bit = std::find_if(bit, back.second, predicate))) {
+            back = bm.pop_back();
+            bit  = back.first;
+            if (back.first == back.second) {
+                auto it = std::partition(fit, front.second, predicate);
+                return std::make_pair(it, front.second);
+            }
+        }
+        std::iter_swap(fit, bit);
+        ++fit;
+        ++bit;
+    }
+}
+
+// The same job processing the blocks using a partition kernel (see
+// partition_kernel.hpp). The branching kernel uses the loops above.
+
+template <typename BlockManager, typename Predicate>
+auto nstd::partition_blocks(BlockManager& bm, Predicate predicate, nstd::branching_kernel)
+    -> decltype(bm.pop_front()) {
+    return nstd::partition_blocks(bm, predicate);
+}
+
+template <typename BlockManager, typename Predicate, typename Kernel>
+auto nstd::partition_blocks(BlockManager& bm, Predicate predicate, Kernel kernel)
+    -> decltype(bm.pop_front()) {
+    auto front = bm.pop_front();
+    auto back  = bm.pop_back();
+    auto fit   = front.first;
+    auto bit   = back.first;
+    while (true) {
+        std::tie(fit, bit) = kernel(fit, front.second, bit, back.second, predicate);
+        if (fit == front.second) {
+            front = bm.pop_front();
+            fit   = front.first;
+            if (front.first == front.second) {
+                auto it = std::partition(back.first, back.second, predicate);
+                return std::make_pair(back.first, it);
+            }
+        }
+        if (bit == back.second) {
+            back = bm.pop_back();
+            bit  = back.first;
+            if (back.first == back.second) {
+                auto it = std::partition(fit, front.second, predicate);
+                return std::make_pair(it, front.second);
+            }
+        }
+    }
+}
+
+// Move the leftover ranges produced by the jobs to the correct side of the
+// midpoint of the block manager and return the resulting partition point.
+
+template <typename RndIt, typename PairIt>
+RndIt nstd::merge_leftovers(RndIt midpoint, PairIt begin, PairIt end) {
+    std::sort(begin, end);
+    auto leftend = std::partition_point(begin, end,
+                                        [=](auto&& p){ return p.first < midpoint; });
+
+    auto rightbegin = leftend;
+    auto leftbegin  = begin;
+    auto rightend   = end;
+    while (leftend != leftbegin) {
+        --leftend;
+        auto size = std::min(std::distance(leftend->first, leftend->second),
+                             std::distance(leftend->second, midpoint));
+        std::swap_ranges(leftend->first, leftend->first + size, midpoint - size);
+        midpoint -= std::distance(leftend->first, leftend->second);
+    }
+    while (rightbegin != rightend) {
+        auto size = std::min(std::distance(rightbegin->first, rightbegin->second),
+                             std::distance(midpoint, rightbegin->first));
+        std::swap_ranges(midpoint, midpoint + size, rightbegin->second - size);
+        midpoint += std::distance(rightbegin->first, rightbegin->second);
+        ++rightbegin;
+    }
+    return midpoint;
+}
+
+// Produce the partition point after all jobs are done from the block
+// manager and the jobs' leftover ranges. All algorithms using
+// nstd::partition_blocks() finish this way, i.e., they work with any block
+// manager.
+
+template <typename BlockManager, typename PairIt>
+auto nstd::finish_partition(BlockManager& bm, PairIt begin, PairIt end)
+    -> decltype(bm.midpoint()) {
+    return nstd::merge_leftovers(bm.midpoint(), begin, end);
+}
+
+// With a block manager split into parts with a midpoint each, e.g.,
+// nstd::block_manager_numa, each part is finished on its own and the
+// elements satisfying the predicate are then moved next to those of the
+// preceding parts: the fix-up moves up to half of each part but it is only
+// done once, after the parallel phase.
+
+template <typename BlockManager, typename PairIt>
+auto nstd::finish_partition(BlockManager& bm, PairIt begin, PairIt end)
+    -> decltype(bm.midpoint(0)) {
+    using RndIt = decltype(bm.midpoint(0));
+    std::sort(begin, end);
+    RndIt midpoint(bm.begin(0));
+    for (int part(0); part != bm.parts(); ++part) {
+        RndIt  pend(bm.end(part));
+        PairIt last(std::partition_point(begin, end,
+                                         [=](auto&& p){ return p.first < pend; }));
+        RndIt  point(nstd::merge_leftovers(bm.midpoint(part), begin, last));
+        auto   count(std::distance(bm.begin(part), point));
+        auto   size(std::min(count, std::distance(midpoint, bm.begin(part))));
+        std::swap_ranges(midpoint, midpoint + size, point - size);
+        midpoint += count;
+        begin = last;
+    }
+    return midpoint;
+}
+
 // ----------------------------------------------------------------------------
 
-template <template <typename, int> class BlockManager>
+template <template <typename, int> class BlockManager, typename Executor, typename Kernel>
 class nstd::parallel_partition {
 private:
-    nstd::thread_pool& d_pool;
-    static constexpr int blocksize = 1024;
-    static constexpr int minblocks = 4;
+    Executor& d_pool;
+
+    template <int BlockSize, typename RndIt, typename Predicate>
+    RndIt run(RndIt begin, RndIt end, Predicate predicate) const;
 
 public:
-    explicit parallel_partition(nstd::thread_pool& pool): d_pool(pool) {}
+    parallel_partition(): d_pool(nstd::default_pool()) {}
+    explicit parallel_partition(Executor& pool): d_pool(pool) {}
     template <typename RndIt, typename Predicate>
     RndIt operator()(RndIt begin, RndIt end, Predicate predicate) const;
 };
 
-template <template <typename, int> class BlockManager>
+template <template <typename, int> class BlockManager, typename Executor, typename Kernel>
 template <typename RndIt, typename Predicate>
-RndIt nstd::parallel_partition<BlockManager>::operator()(RndIt begin, RndIt end, Predicate predicate) const {
-    auto len = std::distance(begin, end);
-    if (len < minblocks * blocksize) {
-        return std::partition(begin, end, predicate);
-    }
-    BlockManager<RndIt, blocksize> bm(begin, end);
-    int maxjobs = this->d_pool.thread_count() / 2;
-    std::vector<std::pair<RndIt, RndIt>> leftover(maxjobs);
-    
-    nstd::latch latch(maxjobs);
-    auto job = [&](auto& lastblock){
-        [&]{
-            auto front = bm.pop_front();
-            auto back  = bm.pop_back();
-            auto fit   = front.first;
-            auto bit   = back.first;
-            while (true) {
-                while (front.second == (fit = std::find_if(fit, front.second, nstd::not_fn(predicate)))) {
-                    front = bm.pop_front();
-                    fit   = front.first;
-                    if (front.first == front.second){
-                        auto it = std::partition(back.first, back.second, predicate);
-                        lastblock = std::make_pair(back.first, it);
-                        return;
-                    }
-                }
-                while (back.second == (bit = std::find_if(bit, back.second, predicate))) {
-                    back = bm.pop_back();
-                    bit  = back.first;
-                    if (back.first == back.second) {
-                        auto it = std::partition(fit, front.second, predicate);
-                        lastblock = std::make_pair(it, front.second);
-                        return;
-                    }
-                }
-                std::iter_swap(fit, bit);
-                ++fit;
-                ++bit;
+RndIt nstd::parallel_partition<BlockManager, Executor, Kernel>::operator()(RndIt begin, RndIt end, Predicate predicate) const {
+    auto tuning = nstd::tuning_for<RndIt>();
+    return nstd::with_block_size(tuning.block_size, [&](auto blocksize){
+            // the cut-off uses the block size actually used
+            if (std::distance(begin, end)
+                < std::ptrdiff_t(tuning.min_blocks) * decltype(blocksize)::value) {
+                return std::partition(begin, end, predicate);
             }
-        }(); // NOTE: there is a call here!
-        
-        latch.arrive();
-    };
-    for (int j = 0; j != maxjobs; ++j) {
-        this->d_pool.enqueue_job([&,j]{ job(leftover[j]); });
-    }
-    latch.wait();
+            return this->template run<decltype(blocksize)::value>(begin, end, predicate);
+        });
+}
 
-    auto p = std::minmax_element(leftover.begin(), leftover.end());
-    begin = p.first->first;
-    end   = p.second->second;
-    return std::partition(begin, end, predicate); //-dk:TODO swap blocks
+template <template <typename, int> class BlockManager, typename Executor, typename Kernel>
+template <int BlockSize, typename RndIt, typename Predicate>
+RndIt nstd::parallel_partition<BlockManager, Executor, Kernel>::run(RndIt begin, RndIt end, Predicate predicate) const {
+    BlockManager<RndIt, BlockSize> bm(begin, end);
+    auto budget = nstd::reserve(this->d_pool, nstd::thread_count(this->d_pool) / 2);
+    int maxjobs = std::max(1, budget.count());
+    nstd::scratch_scope scratch;
+    auto leftover = scratch.allocate<std::pair<RndIt, RndIt>>(maxjobs);
+    
+    nstd::parallel_invoke(this->d_pool, maxjobs, [&](int j){
+            leftover[j] = nstd::partition_blocks(bm, predicate, Kernel());
+        });
 
-    return begin;
+    return nstd::finish_partition(bm, leftover, leftover + maxjobs);
 }
 
 // ----------------------------------------------------------------------------
 
-template <template <typename, int> class BlockManager>
+template <template <typename, int> class BlockManager, typename Executor, typename Kernel>
 class nstd::parallel_partition2 {
 private:
-    nstd::thread_pool& d_pool;
-    static constexpr int blocksize = 1024;
-    static constexpr int minblocks = 4;
+    Executor& d_pool;
+
+    template <int BlockSize, typename RndIt, typename Predicate>
+    RndIt run(RndIt begin, RndIt end, Predicate predicate) const;
 
 public:
-    explicit parallel_partition2(nstd::thread_pool& pool): d_pool(pool) {}
+    parallel_partition2(): d_pool(nstd::default_pool()) {}
+    explicit parallel_partition2(Executor& pool): d_pool(pool) {}
     template <typename RndIt, typename Predicate>
     RndIt operator()(RndIt begin, RndIt end, Predicate predicate) const;
 };
 
-template <template <typename, int> class BlockManager>
+template <template <typename, int> class BlockManager, typename Executor, typename Kernel>
 template <typename RndIt, typename Predicate>
-RndIt nstd::parallel_partition2<BlockManager>::operator()(RndIt begin, RndIt end, Predicate predicate) const {
-    auto len = std::distance(begin, end);
-    if (len < minblocks * blocksize) {
-        return std::partition(begin, end, predicate);
-    }
-    BlockManager<RndIt, blocksize> bm(begin, end);
-    int maxjobs = this->d_pool.thread_count();
-    std::vector<std::pair<RndIt, RndIt>> leftover(maxjobs);
-    
-    nstd::latch latch(maxjobs);
-    auto job = [&](auto& lastblock){
-        [&]{
-            auto front = bm.pop_front();
-            auto back  = bm.pop_back();
-            auto fit   = front.first;
-            auto bit   = back.first;
-            while (true) {
-                while (front.second == (fit = std::find_if(fit, front.second, nstd::not_fn(predicate)))) {
-                    front = bm.pop_front();
-                    fit   = front.first;
-                    if (front.first == front.second){
-                        auto it = std::partition(back.first, back.second, predicate);
-                        lastblock = std::make_pair(back.first, it);
-                        return;
-                    }
-                }
-                while (back.second == (bit = std::find_if(bit, back.second, predicate))) {
-                    back = bm.pop_back();
-                    bit  = back.first;
-                    if (back.first == back.second) {
-                        auto it = std::partition(fit, front.second, predicate);
-                        lastblock = std::make_pair(it, front.second);
-                        return;
-                    }
-                }
-                std::iter_swap(fit, bit);
-                ++fit;
-                ++bit;
+RndIt nstd::parallel_partition2<BlockManager, Executor, Kernel>::operator()(RndIt begin, RndIt end, Predicate predicate) const {
+    auto tuning = nstd::tuning_for<RndIt>();
+    return nstd::with_block_size(tuning.block_size, [&](auto blocksize){
+            // the cut-off uses the block size actually used
+            if (std::distance(begin, end)
+                < std::ptrdiff_t(tuning.min_blocks) * decltype(blocksize)::value) {
+                return std::partition(begin, end, predicate);
             }
-        }(); // NOTE: there is a call here!
-        
-        latch.arrive();
-    };
-    for (int j = 0; j != maxjobs; ++j) {
-        this->d_pool.enqueue_job([&,j]{ job(leftover[j]); });
-    }
-    latch.wait();
+            return this->template run<decltype(blocksize)::value>(begin, end, predicate);
+        });
+}
 
-    auto midpoint = bm.midpoint();
-    std::sort(leftover.begin(), leftover.end());
-    auto leftend = std::partition_point(leftover.begin(), leftover.end(),
-                                        [=](auto&& p){ return p.first < midpoint; });
+template <template <typename, int> class BlockManager, typename Executor, typename Kernel>
+template <int BlockSize, typename RndIt, typename Predicate>
+RndIt nstd::parallel_partition2<BlockManager, Executor, Kernel>::run(RndIt begin, RndIt end, Predicate predicate) const {
+    BlockManager<RndIt, BlockSize> bm(begin, end);
+    auto budget = nstd::reserve(this->d_pool, nstd::thread_count(this->d_pool));
+    int maxjobs = std::max(1, budget.count());
+    nstd::scratch_scope scratch;
+    auto leftover = scratch.allocate<std::pair<RndIt, RndIt>>(maxjobs);
+    
+    nstd::parallel_invoke(this->d_pool, maxjobs, [&](int j){
+            leftover[j] = nstd::partition_blocks(bm, predicate, Kernel());
+        });
 
-    auto rightbegin = leftend;
-    auto leftbegin  = leftover.begin();
-    auto rightend   = leftover.end();
-    while (leftend != leftbegin) {
-        --leftend;
-        auto size = std::min(std::distance(leftend->first, leftend->second),
-                             std::distance(leftend->second, midpoint));
-        std::swap_ranges(leftend->first, leftend->first + size, midpoint - size);
-        midpoint -= std::distance(leftend->first, leftend->second);
-    }
-    while (rightbegin != rightend) {
-        auto size = std::min(std::distance(rightbegin->first, rightbegin->second),
-                             std::distance(midpoint, rightbegin->first));
-        std::swap_ranges(midpoint, midpoint + size, rightbegin->second - size);
-        midpoint += std::distance(rightbegin->first, rightbegin->second);
-        ++rightbegin;
-    }
-    return midpoint;
+    return nstd::finish_partition(bm, leftover, leftover + maxjobs);
 }
 
 // ----------------------------------------------------------------------------
 
-template <template <typename, int> class BlockManager>
+template <template <typename, int> class BlockManager, typename Executor, typename Kernel>
 class nstd::parallel_partition3 {
 private:
-    nstd::thread_pool& d_pool;
-    static constexpr int blocksize = 1024;
-    static constexpr int minblocks = 4;
+    Executor& d_pool;
+
+    template <int BlockSize, typename RndIt, typename Predicate>
+    RndIt run(RndIt begin, RndIt end, Predicate predicate) const;
+
+    // The hand-written loops are used with the branching kernel.
+    template <typename Job, typename Pair, typename BM, typename Predicate>
+    static void run_job(Job& job, Pair& leftover, BM&, Predicate, nstd::branching_kernel) {
+        job(leftover);
+    }
+    template <typename Job, typename Pair, typename BM, typename Predicate, typename K>
+    static void run_job(Job&, Pair& leftover, BM& bm, Predicate predicate, K kernel) {
+        leftover = nstd::partition_blocks(bm, predicate, kernel);
+    }
 
 public:
-    explicit parallel_partition3(nstd::thread_pool& pool): d_pool(pool) {}
+    parallel_partition3(): d_pool(nstd::default_pool()) {}
+    explicit parallel_partition3(Executor& pool): d_pool(pool) {}
     template <typename RndIt, typename Predicate>
     RndIt operator()(RndIt begin, RndIt end, Predicate predicate) const;
 };
 
-template <template <typename, int> class BlockManager>
+template <template <typename, int> class BlockManager, typename Executor, typename Kernel>
 template <typename RndIt, typename Predicate>
-RndIt nstd::parallel_partition3<BlockManager>::operator()(RndIt begin, RndIt end, Predicate predicate) const {
-    auto len = std::distance(begin, end);
-    if (len < minblocks * blocksize) {
-        return std::partition(begin, end, predicate);
-    }
-    BlockManager<RndIt, blocksize> bm(begin, end);
-    int maxjobs = this->d_pool.thread_count();
-    std::vector<std::pair<RndIt, RndIt>> leftover(maxjobs);
+RndIt nstd::parallel_partition3<BlockManager, Executor, Kernel>::operator()(RndIt begin, RndIt end, Predicate predicate) const {
+    auto tuning = nstd::tuning_for<RndIt>();
+    return nstd::with_block_size(tuning.block_size, [&](auto blocksize){
+            // the cut-off uses the block size actually used
+            if (std::distance(begin, end)
+                < std::ptrdiff_t(tuning.min_blocks) * decltype(blocksize)::value) {
+                return std::partition(begin, end, predicate);
+            }
+            return this->template run<decltype(blocksize)::value>(begin, end, predicate);
+        });
+}
+
+template <template <typename, int> class BlockManager, typename Executor, typename Kernel>
+template <int BlockSize, typename RndIt, typename Predicate>
+RndIt nstd::parallel_partition3<BlockManager, Executor, Kernel>::run(RndIt begin, RndIt end, Predicate predicate) const {
+    BlockManager<RndIt, BlockSize> bm(begin, end);
+    auto budget = nstd::reserve(this->d_pool, nstd::thread_count(this->d_pool));
+    int maxjobs = std::max(1, budget.count());
+    nstd::scratch_scope scratch;
+    auto leftover = scratch.allocate<std::pair<RndIt, RndIt>>(maxjobs);
     
-    nstd::latch latch(maxjobs);
     auto job = [&](auto& lastblock){
         [&]{
             auto front = bm.pop_front();
@@ -376,38 +493,38 @@ RndIt nstd::parallel_partition3<BlockManager>::operator()(RndIt begin, RndIt end
                 ++bit;
             }
         }(); // NOTE: there is a call here!
-        
-        latch.arrive();
     };
-    for (int j = 0; j != maxjobs; ++j) {
-        this->d_pool.enqueue_job([&,j]{ job(leftover[j]); });
-    }
-    latch.wait();
+    nstd::parallel_invoke(this->d_pool, maxjobs, [&](int j){
+            run_job(job, leftover[j], bm, predicate, Kernel());
+        });
 
-    auto midpoint = bm.midpoint();
-    std::sort(leftover.begin(), leftover.end());
-    auto leftend = std::partition_point(leftover.begin(), leftover.end(),
-                                        [=](auto&& p){ return p.first < midpoint; });
+    return nstd::finish_partition(bm, leftover, leftover + maxjobs);
+}
 
-    auto rightbegin = leftend;
-    auto leftbegin  = leftover.begin();
-    auto rightend   = leftover.end();
-    while (leftend != leftbegin) {
-        --leftend;
-        auto size = std::min(std::distance(leftend->first, leftend->second),
-                             std::distance(leftend->second, midpoint));
-        std::swap_ranges(leftend->first, leftend->first + size, midpoint - size);
-        midpoint -= std::distance(leftend->first, leftend->second);
+// ----------------------------------------------------------------------------
+// nstd::parallel_partition2 using the block manager from the tuning profile.
+
+template <typename Executor>
+class nstd::tuned_partition {
+private:
+    Executor& d_pool;
+
+    template <template <typename, int> class BlockManager, typename RndIt, typename Predicate>
+    RndIt run(nstd::block_manager_tag<BlockManager>,
+              RndIt begin, RndIt end, Predicate predicate) const {
+        return nstd::parallel_partition2<BlockManager, Executor>(this->d_pool)(begin, end, predicate);
     }
-    while (rightbegin != rightend) {
-        auto size = std::min(std::distance(rightbegin->first, rightbegin->second),
-                             std::distance(midpoint, rightbegin->first));
-        std::swap_ranges(midpoint, midpoint + size, rightbegin->second - size);
-        midpoint += std::distance(rightbegin->first, rightbegin->second);
-        ++rightbegin;
+
+public:
+    tuned_partition(): d_pool(nstd::default_pool()) {}
+    explicit tuned_partition(Executor& pool): d_pool(pool) {}
+    template <typename RndIt, typename Predicate>
+    RndIt operator()(RndIt begin, RndIt end, Predicate predicate) const {
+        return nstd::with_block_manager(nstd::tuning_for<RndIt>().block_manager, [&](auto tag){
+                return this->run(tag, begin, end, predicate);
+            });
     }
-    return midpoint;
-}
+};
 
 // ----------------------------------------------------------------------------
 
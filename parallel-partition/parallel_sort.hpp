@@ -30,6 +30,8 @@
 #include "latch.hpp"
 #include "block_manager.hpp"
 #include "parallel_partition.hpp"
+#include "simd_kernel.hpp"
+#include "tuning.hpp"
 #include <algorithm>
 #include <atomic>
 #include <memory>
@@ -61,26 +63,28 @@ void async_sort_with(nstd::thread_pool& pool, Continuation continuation, RndIt b
         Continuation       continuation;
         Compare            compare;
         std::atomic<int>   active;
+        long               cutoff;
 
         control(nstd::thread_pool& pool, Continuation continuation, Compare compare)
             : pool(pool)
             , continuation(std::move(continuation))
             , compare(compare)
-            , active(0) {
+            , active(0)
+            , cutoff(nstd::tuning_for<RndIt>().sort_cutoff) {
         }
         void do_it(RndIt begin, RndIt end) {
             auto size = std::distance(begin, end);
-            if (size < 8000) {
+            if (size < this->cutoff) {
                 std::sort(begin, end, this->compare);
                 return this->clean_up();
             }
 
             auto mid = begin + size / 2;
             std::iter_swap(mid, end - 1);
-            auto partition_pred = [=, pivot=*(end - 1)](auto const& value) {
-                return this->compare(value, pivot);
-            };
-            auto partition_point = nstd::parallel_partition<BlockManager>(pool)(begin, end - 1, partition_pred);
+            auto partition_pred = nstd::pivot_predicate(this->compare, *(end - 1));
+            auto partition_point = nstd::parallel_partition<BlockManager, nstd::thread_pool,
+                                                            nstd::simd_kernel>(pool)(
+                begin, end - 1, partition_pred);
             std::iter_swap(end - 1, partition_point);
             if (begin != partition_point) {
                 ++this->active;
@@ -115,6 +119,7 @@ void async_sort_with(nstd::thread_pool& pool, Continuation continuation, RndIt b
 template <template<typename, int> class BlockManager>
 struct parallel_sort_with_async {
     nstd::thread_pool& d_pool;
+    parallel_sort_with_async(): d_pool(nstd::default_pool()) {}
     parallel_sort_with_async(nstd::thread_pool& pool): d_pool(pool) {}
 
     template <typename It, typename Compare>
@@ -123,7 +128,7 @@ struct parallel_sort_with_async {
         async_sort_with<BlockManager>(this->d_pool, [&]{ latch.arrive(); },
                                       begin, end, compare);
                                       
-        latch.wait();
+        this->d_pool.join(latch);
     }
 };
 
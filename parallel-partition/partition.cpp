@@ -27,8 +27,11 @@
 #include "lomuto_partition.hpp"
 #include "hoare_partition.hpp"
 #include "parallel_partition.hpp"
+#include "simd_kernel.hpp"
+#include "first_touch.hpp"
 #include "timer.hpp"
 #include <algorithm>
+#include <climits>
 #include <exception>
 #include <iomanip>
 #include <iostream>
@@ -39,6 +42,35 @@
 
 // ----------------------------------------------------------------------------
 
+using container = std::vector<int, nstd::default_init_allocator<int>>;
+
+// ----------------------------------------------------------------------------
+// nstd::block_manager_numa splitting the range into three parts even on a
+// machine with just one NUMA node: the merge of the parts gets tested.
+
+template <typename RndIt, int Size>
+class block_manager_numa3
+    : public nstd::block_manager_numa<RndIt, Size> {
+public:
+    block_manager_numa3(RndIt begin, RndIt end)
+        : nstd::block_manager_numa<RndIt, Size>(begin, end, 3) {
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+template <typename Container>
+Container first_touch_copy(nstd::thread_pool& pool, Container const& original) {
+    Container container(original.size());
+    nstd::first_touch(pool, container.begin(), container.end(), [&](auto b, auto e){
+            auto it = original.begin() + (b - container.begin());
+            std::copy(it, it + (e - b), b);
+        });
+    return container;
+}
+
+// ----------------------------------------------------------------------------
+
 template <typename Partition, typename Container, typename Predicate>
 auto test(Partition partition, Container container, Predicate predicate)
     -> std::pair<utility::timer_duration, bool> {
@@ -55,116 +87,147 @@ auto test(Partition partition, Container container, Predicate predicate)
 // ----------------------------------------------------------------------------
 
 template <typename Partition, typename Container, typename Predicate>
-void test(std::string const& prefix, std::string const& name, Partition partition,
-          Container const& container, Predicate predicate) {
+void test(nstd::thread_pool& pool, std::string const& prefix, std::string const& name,
+          Partition partition, Container const& container, Predicate predicate) {
+    auto copy  = first_touch_copy(pool, container);
+    auto stats = pool.stats();
 #ifdef CXX17
-    auto[time, rc] = test(partition, container, predicate);
+    auto[time, rc] = test(partition, std::move(copy), predicate);
+    stats = pool.stats() - stats;
     std::cout << std::setw(60) << name << ' '
               << (rc? "passed": "\x1b[31mfailed\x1b[0m") << ' '
-              << time << ' '
-              << '\n' << std::flush;
+              << time << ' ';
+    if (stats.enabled) {
+        std::cout << stats << ' ';
+    }
+    std::cout << '\n' << std::flush;
 #elif 0
-    auto p = test(partition, container, predicate);
+    auto p = test(partition, std::move(copy), predicate);
     std::cout << std::setw(60) << name << ' '
               << (p.second? "passed": "\x1b[31mfailed\x1b[0m") << ' '
               << p.first << ' '
               << '\n' << std::flush;
 #else
-    auto p = test(partition, container, predicate);
+    auto p = test(partition, std::move(copy), predicate);
+    stats = pool.stats() - stats;
     std::cout << prefix
               << "\"name\"=\"" << name << "\", "
               << "\"time\"=\"" << p.first << "\", "
-              << "\"result\"=\"" << (p.second? "passed": "failed") << "\" "
-              << "},\n" << std::flush;
+              << "\"result\"=\"" << (p.second? "passed": "failed") << "\" ";
+    if (stats.enabled) {
+        std::cout << ", \"stats\"=\"" << stats << "\" ";
+    }
+    std::cout << "},\n" << std::flush;
 #endif
 }
 
 // ----------------------------------------------------------------------------
 
 template <typename Predicate>
-void run_test(std::string const& prefix, std::vector<int> const& v, Predicate predicate)
+void run_test(std::string const& prefix, container const& v, Predicate predicate)
 {
+    nstd::thread_pool& pool(nstd::default_pool());
 #if 1
-    test(prefix, "std::partition", [](auto begin, auto end, auto pred) {
+    test(pool, prefix, "std::partition", [](auto begin, auto end, auto pred) {
             return std::partition(begin, end, pred);
         }, v, predicate);
-    test(prefix, "blocked", [](auto begin, auto end, auto pred) {
+    test(pool, prefix, "blocked", [](auto begin, auto end, auto pred) {
             return blocked(begin, end, pred);
         }, v, predicate);
 #endif
-    {
-        thread_pool pool1(std::thread::hardware_concurrency());
-    test(prefix, "blocked(pool)", [&pool1](auto begin, auto end, auto pred) {
-            return blocked(pool1, begin, end, pred);
+    test(pool, prefix, "blocked(pool)", [&pool](auto begin, auto end, auto pred) {
+            return blocked(pool, begin, end, pred);
+        }, v, predicate);
+    test(pool, prefix, "blocked<nstd::branchless_kernel>", [](auto begin, auto end, auto pred) {
+            return blocked(begin, end, pred, nstd::branchless_kernel());
+        }, v, predicate);
+    test(pool, prefix, "blocked(pool)<nstd::branchless_kernel>", [&pool](auto begin, auto end, auto pred) {
+            return blocked(pool, begin, end, pred, nstd::branchless_kernel());
         }, v, predicate);
-    }
 #if 1
-    //test(prefix, "std::partition", [](auto begin, auto end, auto pred) {
+    //test(pool, prefix, "std::partition", [](auto begin, auto end, auto pred) {
     //        return std::partition(begin, end, pred);
     //    }, v, predicate);
-    //test(prefix, "lomuto_partition1", [](auto begin, auto end, auto pred) {
+    //test(pool, prefix, "lomuto_partition1", [](auto begin, auto end, auto pred) {
     //        return lomuto_partition1(begin, end, pred);
     //    }, v, predicate);
-    //test(prefix, "lomuto_partition2", [](auto begin, auto end, auto pred) {
+    //test(pool, prefix, "lomuto_partition2", [](auto begin, auto end, auto pred) {
     //        return lomuto_partition2(begin, end, pred);
     //    }, v, predicate);
-    test(prefix, "lomuto_partition3", [](auto begin, auto end, auto pred) {
+    test(pool, prefix, "lomuto_partition3", [](auto begin, auto end, auto pred) {
             return lomuto_partition3(begin, end, pred);
         }, v, predicate);
-    test(prefix, "hoare_partition", [](auto begin, auto end, auto pred) {
+    test(pool, prefix, "hoare_partition", [](auto begin, auto end, auto pred) {
             return hoare_partition(begin, end, pred);
         }, v, predicate);
-    //test(prefix, "blocked_partition", [](auto begin, auto end, auto pred) {
+    //test(pool, prefix, "blocked_partition", [](auto begin, auto end, auto pred) {
     //        return blocked_partition(begin, end, pred);
     //    }, v, predicate);
-    //test(prefix, "algorithm_partition", [](auto begin, auto end, auto pred) {
+    //test(pool, prefix, "algorithm_partition", [](auto begin, auto end, auto pred) {
     //        return algorithm_partition(begin, end, pred);
     //    }, v, predicate);
-    //test(prefix, "sentinel_partition", [](auto begin, auto end, auto pred) {
+    //test(pool, prefix, "sentinel_partition", [](auto begin, auto end, auto pred) {
     //        return sentinel_partition(begin, end, pred);
     //    }, v, predicate);
-    // test(prefix, "parallel_partition", [](auto begin, auto end, auto pred) {
+    // test(pool, prefix, "parallel_partition", [](auto begin, auto end, auto pred) {
     //         return parallel_partition(begin, end, pred);
     //     }, v, predicate);
 #endif
-    nstd::thread_pool pool(std::thread::hardware_concurrency());
-    pool.start();
 #if 0
-    test(prefix, "parallel_partition<nstd::block_manager>",
+    test(pool, prefix, "parallel_partition<nstd::block_manager>",
          nstd::parallel_partition<nstd::block_manager>(pool), v, predicate);
-    test(prefix, "parallel_partition2<nstd::block_manager>",
+    test(pool, prefix, "parallel_partition2<nstd::block_manager>",
          nstd::parallel_partition2<nstd::block_manager>(pool), v, predicate);
-    test(prefix, "parallel_partition3<nstd::block_manager>",
+    test(pool, prefix, "parallel_partition3<nstd::block_manager>",
          nstd::parallel_partition3<nstd::block_manager>(pool), v, predicate);
-    test(prefix, "parallel_partition<nstd::block_manager_atomic>",
+    test(pool, prefix, "parallel_partition<nstd::block_manager_atomic>",
          nstd::parallel_partition<nstd::block_manager_atomic>(pool), v, predicate);
-    test(prefix, "parallel_partition2<nstd::block_manager_atomic>",
+    test(pool, prefix, "parallel_partition2<nstd::block_manager_atomic>",
          nstd::parallel_partition2<nstd::block_manager_atomic>(pool), v, predicate);
-    test(prefix, "parallel_partition3<nstd::block_manager_atomic>",
+    test(pool, prefix, "parallel_partition3<nstd::block_manager_atomic>",
          nstd::parallel_partition3<nstd::block_manager_atomic>(pool), v, predicate);
-    test(prefix, "parallel_partition<nstd::block_manager_padded_atomic>",
+    test(pool, prefix, "parallel_partition<nstd::block_manager_padded_atomic>",
          nstd::parallel_partition<nstd::block_manager_padded_atomic>(pool), v, predicate);
-    test(prefix, "parallel_partition2<nstd::block_manager_padded_atomic>",
+    test(pool, prefix, "parallel_partition2<nstd::block_manager_padded_atomic>",
          nstd::parallel_partition2<nstd::block_manager_padded_atomic>(pool), v, predicate);
-    test(prefix, "parallel_partition3<nstd::block_manager_padded_atomic>",
+    test(pool, prefix, "parallel_partition3<nstd::block_manager_padded_atomic>",
          nstd::parallel_partition3<nstd::block_manager_padded_atomic>(pool), v, predicate);
 #endif
 #if 1
-    //test(prefix, "parallel_partition<nstd::block_manager_relaxed>",
+    //test(pool, prefix, "parallel_partition<nstd::block_manager_relaxed>",
     //     nstd::parallel_partition<nstd::block_manager_relaxed>(pool), v, predicate);
-    test(prefix, "parallel_partition2<nstd::block_manager_relaxed>",
+    test(pool, prefix, "parallel_partition2<nstd::block_manager_relaxed>",
          nstd::parallel_partition2<nstd::block_manager_relaxed>(pool), v, predicate);
-    //test(prefix, "parallel_partition3<nstd::block_manager_relaxed>",
+    test(pool, prefix, "parallel_partition2<nstd::block_manager_relaxed, nstd::branchless_kernel>",
+         nstd::parallel_partition2<nstd::block_manager_relaxed, nstd::thread_pool,
+                                   nstd::branchless_kernel>(pool), v, predicate);
+    test(pool, prefix, "parallel_partition2<nstd::block_manager_guided>",
+         nstd::parallel_partition2<nstd::block_manager_guided>(pool), v, predicate);
+    test(pool, prefix, "parallel_partition2<nstd::block_manager_packed>",
+         nstd::parallel_partition2<nstd::block_manager_packed>(pool), v, predicate);
+    test(pool, prefix, "parallel_partition<nstd::block_manager_numa>",
+         nstd::parallel_partition<nstd::block_manager_numa>(pool), v, predicate);
+    test(pool, prefix, "parallel_partition2<nstd::block_manager_numa>",
+         nstd::parallel_partition2<nstd::block_manager_numa>(pool), v, predicate);
+    test(pool, prefix, "parallel_partition<block_manager_numa3>",
+         nstd::parallel_partition<block_manager_numa3>(pool), v, predicate);
+    test(pool, prefix, "parallel_partition2<block_manager_numa3>",
+         nstd::parallel_partition2<block_manager_numa3>(pool), v, predicate);
+    test(pool, prefix, "parallel_partition3<block_manager_numa3>",
+         nstd::parallel_partition3<block_manager_numa3>(pool), v, predicate);
+    test(pool, prefix, "tuned_partition",
+         nstd::tuned_partition<>(pool), v, predicate);
+    //test(pool, prefix, "parallel_partition3<nstd::block_manager_relaxed>",
     //     nstd::parallel_partition3<nstd::block_manager_relaxed>(pool), v, predicate);
 #endif
 }
 
 // ----------------------------------------------------------------------------
 
-void run_tests(int size)
+void run_tests(long long size)
 {
     std::minstd_rand rnd(0);
-    std::vector<int> v;
+    container v;
     // std::cout << "generating\n" << std::flush;
     std::generate_n(std::back_inserter(v), size, [size,&rnd]{ return rnd() % size; });
 
@@ -179,6 +242,14 @@ void run_tests(int size)
 #endif
         auto predicate([size, divisor](auto const& value){ return value < size / divisor; });
         run_test(prefix.str(), v, predicate);
+
+        // the vectorised classification needs the pivot as element type:
+        // the values are less than INT_MAX, i.e., clamping is equivalent
+        nstd::less_than<int> threshold{int(std::min<long long>(size / divisor, INT_MAX))};
+        nstd::thread_pool&   pool(nstd::default_pool());
+        test(pool, prefix.str(), "parallel_partition2<nstd::block_manager_relaxed, nstd::simd_kernel>",
+             nstd::parallel_partition2<nstd::block_manager_relaxed, nstd::thread_pool,
+                                       nstd::simd_kernel>(pool), v, threshold);
     }
 }
 
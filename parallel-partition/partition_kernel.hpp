@@ -0,0 +1,157 @@
+// partition_kernel.hpp                                              -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#ifndef INCLUDED_PARTITION_KERNEL
+#define INCLUDED_PARTITION_KERNEL
+
+#include "not_fn.hpp"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+// ----------------------------------------------------------------------------
+// A partition kernel processes a front block [fit, fend) and a back block
+// [bit, bend): misplaced elements are swapped between the blocks until one
+// of them is done. The result (fit', bit') is the progress made, i.e., all
+// elements in [fit, fit') satisfy the predicate, none of the elements in
+// [bit, bit') does, and fit' == fend or bit' == bend.
+//
+// - branching_kernel:  searches for the next misplaced element on each
+//                      side: a branch per element which is mispredicted
+//                      often when the predicate is unpredictable.
+// - branchless_kernel: like BlockQuicksort, classifies chunks of both
+//                      blocks into buffers of offsets of the misplaced
+//                      elements without branching on the predicate and
+//                      then swaps pairs from the buffers. The
+//                      classification is done by a Classifier which
+//                      allows vectorised classification (see
+//                      simd_kernel.hpp).
+
+namespace nstd {
+    struct branching_kernel;
+    struct scalar_classifier;
+    template <typename Classifier> struct chunked_kernel;
+    using branchless_kernel = nstd::chunked_kernel<nstd::scalar_classifier>;
+}
+
+// ----------------------------------------------------------------------------
+
+struct nstd::branching_kernel {
+    template <typename RndIt, typename Predicate>
+    std::pair<RndIt, RndIt> operator()(RndIt fit, RndIt fend, RndIt bit, RndIt bend,
+                                       Predicate predicate) const {
+        while (true) {
+            if (fend == (fit = std::find_if(fit, fend, nstd::not_fn(predicate)))
+                || bend == (bit = std::find_if(bit, bend, predicate))) {
+                return std::make_pair(fit, bit);
+            }
+            std::iter_swap(fit, bit);
+            ++fit;
+            ++bit;
+        }
+    }
+};
+
+// ----------------------------------------------------------------------------
+// A classifier stores the offsets of the elements in [it, it + size) for
+// which bool(predicate(*it)) == Satisfying into offsets and returns their
+// number. The size is at most chunked_kernel::chunk and a classifier may
+// write up to chunked_kernel::slack bytes past the last offset stored.
+
+struct nstd::scalar_classifier {
+    template <bool Satisfying, typename RndIt, typename Predicate>
+    static int classify(RndIt it, int size, unsigned char* offsets,
+                        Predicate& predicate) {
+        int count(0);
+        for (int i(0); i != size; ++i) {
+            offsets[count] = static_cast<unsigned char>(i);
+            count += bool(predicate(it[i])) == Satisfying;
+        }
+        return count;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// The offsets buffers hold the positions of the misplaced elements within
+// the current chunk of each side: the count is incremented by the result of
+// the predicate instead of conditionally storing the offset. A side moves to
+// its next chunk once all of its misplaced elements are swapped. If a side
+// runs out, the other side's progress is up to its first misplaced element
+// not swapped, yet.
+
+template <typename Classifier>
+struct nstd::chunked_kernel {
+    static constexpr int chunk = 128;
+    static constexpr int slack = 16;
+
+    template <typename RndIt, typename Predicate>
+    std::pair<RndIt, RndIt> operator()(RndIt fit, RndIt fend, RndIt bit, RndIt bend,
+                                       Predicate predicate) const {
+        using difference_type = typename std::iterator_traits<RndIt>::difference_type;
+        unsigned char   front[chunk + slack];
+        unsigned char   back[chunk + slack];
+        difference_type fsize(0), bsize(0);
+        int             fstart(0), fcount(0), bstart(0), bcount(0);
+
+        while (true) {
+            if (fcount == 0) {
+                fit   += fsize;
+                fsize  = std::min(difference_type(chunk), std::distance(fit, fend));
+                fstart = 0;
+                fcount = Classifier::template classify<false>(fit, int(fsize), front, predicate);
+                if (fcount == 0) {
+                    if (fsize == 0) {
+                        return std::make_pair(fend, bit + (bcount? back[bstart]: bsize));
+                    }
+                    continue;
+                }
+            }
+            if (bcount == 0) {
+                bit   += bsize;
+                bsize  = std::min(difference_type(chunk), std::distance(bit, bend));
+                bstart = 0;
+                bcount = Classifier::template classify<true>(bit, int(bsize), back, predicate);
+                if (bcount == 0) {
+                    if (bsize == 0) {
+                        return std::make_pair(fit + front[fstart], bend);
+                    }
+                    continue;
+                }
+            }
+            int count(std::min(fcount, bcount));
+            for (int i(0); i != count; ++i) {
+                std::iter_swap(fit + front[fstart + i], bit + back[bstart + i]);
+            }
+            fstart += count;
+            fcount -= count;
+            bstart += count;
+            bcount -= count;
+        }
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,100 @@
+// phases.cpp                                                        -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#include "barrier.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Runs threads through many phases of an nstd::barrier and checks its
+// completion step: it has to run exactly once per phase, after all threads
+// arrived for the phase and before any of them continues into the next
+// one. The report also shows the time per phase.
+
+void measure(int threads, int phases) {
+    std::atomic<long> arrived(0);
+    std::atomic<long> completions(0);
+    std::atomic<int>  running(0);
+    std::atomic<bool> ok(true);
+
+    auto completion = [&]{
+        if (0 != running++) {
+            ok = false;
+        }
+        long phase(completions.load());
+        if (arrived.load() != threads * (phase + 1)) {
+            ok = false;
+        }
+        ++completions;
+        --running;
+    };
+    nstd::barrier<decltype(completion)> barrier(threads, completion);
+
+    std::vector<std::thread> pool;
+    auto start(std::chrono::steady_clock::now());
+    for (int t(0); t != threads; ++t) {
+        pool.emplace_back([&]{
+                for (long phase(0); phase != phases; ++phase) {
+                    ++arrived;
+                    barrier.arrive_and_wait();
+                    if (completions.load() != phase + 1) {
+                        ok = false;
+                    }
+                }
+            });
+    }
+    for (auto& thread: pool) {
+        thread.join();
+    }
+    auto time(std::chrono::steady_clock::now() - start);
+    bool rc(ok && completions == phases);
+    std::cout << "threads=" << std::setw(3) << threads << ' '
+              << "phases=" << phases << ' '
+              << (rc? "passed": "\x1b[31mfailed\x1b[0m") << ' '
+              << std::setw(8)
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(time).count() / phases
+              << "ns/phase"
+              << '\n' << std::flush;
+}
+
+// ----------------------------------------------------------------------------
+
+int main() {
+    try {
+        int maxthreads(std::max(4u, std::thread::hardware_concurrency()));
+        for (int threads(1); threads <= maxthreads; threads *= 2) {
+            measure(threads, 10000);
+        }
+    }
+    catch (std::exception const& ex) {
+        std::cerr << "ERROR: " << ex.what() << '\n';
+    }
+}
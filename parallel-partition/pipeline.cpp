@@ -0,0 +1,130 @@
+// pipeline.cpp                                                      -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#include "coroutine.hpp"
+#include "thread_pool.hpp"
+#include "parallel_sort.hpp"
+#include "latch.hpp"
+#include "timer.hpp"
+#include <algorithm>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Simulates request handlers each of which sorts the two halves of its data
+// concurrently and merges the results. The coroutine version awaits the
+// sorts (nstd::async_sort() and nstd::when_all()) while the blocking version
+// uses parallel_sort_with_async from within a job. Requires C++20.
+
+using container = std::vector<int>;
+
+template <typename Run>
+void measure(std::string const& name, std::vector<container> const& requests, Run run) {
+    std::vector<container> data(requests);
+    utility::timer timer;
+    timer.start();
+    run(data);
+    auto time = timer.stop();
+    bool rc = std::all_of(data.begin(), data.end(), [](auto const& c){
+            return std::is_sorted(c.begin(), c.end());
+        });
+    std::cout << std::setw(40) << name << ' '
+              << "requests=" << std::setw(3) << requests.size() << ' '
+              << (rc? "passed": "\x1b[31mfailed\x1b[0m") << ' '
+              << time << '\n' << std::flush;
+}
+
+// ----------------------------------------------------------------------------
+
+nstd::task<void> handle_request(nstd::thread_pool& pool, container& c) {
+    co_await pool.schedule();
+    auto compare = [](int v0, int v1){ return v0 < v1; };
+    auto mid = c.begin() + c.size() / 2;
+    co_await nstd::when_all(pool,
+                            nstd::async_sort(pool, c.begin(), mid, compare),
+                            nstd::async_sort(pool, mid, c.end(), compare));
+    std::inplace_merge(c.begin(), mid, c.end(), compare);
+}
+
+nstd::task<void> handle_requests(nstd::thread_pool& pool, std::vector<container>& data) {
+    std::vector<nstd::task<void>> handlers;
+    for (auto& c: data) {
+        handlers.push_back(handle_request(pool, c));
+    }
+    co_await nstd::when_all(pool, std::move(handlers));
+}
+
+void blocking_requests(nstd::thread_pool& pool, std::vector<container>& data) {
+    auto compare = [](int v0, int v1){ return v0 < v1; };
+    parallel_sort_with_async<nstd::block_manager_relaxed> sort(pool);
+    nstd::latch latch(int(data.size()));
+    pool.enqueue_bulk(int(data.size()), [&](int i){
+            container& c(data[i]);
+            auto mid = c.begin() + c.size() / 2;
+            nstd::latch halves(2);
+            pool.enqueue_job([&]{ sort(c.begin(), mid, compare); halves.arrive(); });
+            sort(mid, c.end(), compare);
+            halves.arrive();
+            pool.join(halves);
+            std::inplace_merge(c.begin(), mid, c.end(), compare);
+            latch.arrive();
+        });
+    pool.join(latch);
+}
+
+// ----------------------------------------------------------------------------
+
+int main() {
+    try {
+        nstd::thread_pool pool(std::thread::hardware_concurrency(),
+                               nstd::thread_pool::mode::work_stealing);
+        pool.start();
+
+        std::minstd_rand rnd(0);
+        for (int size: { 100000, 1000000, 10000000 }) {
+            for (int count: { 1, 4, 16 }) {
+                std::vector<container> requests(count);
+                for (auto& c: requests) {
+                    std::generate_n(std::back_inserter(c), size, [size,&rnd]{ return rnd() % size; });
+                }
+                std::cout << "--- size=" << size << '\n';
+                measure("blocking", requests, [&](auto& data){
+                        blocking_requests(pool, data);
+                    });
+                measure("coroutines", requests, [&](auto& data){
+                        nstd::sync_wait(pool, handle_requests(pool, data));
+                    });
+            }
+        }
+    }
+    catch (std::exception const& ex) {
+        std::cerr << "ERROR: " << ex.what() << '\n';
+    }
+}
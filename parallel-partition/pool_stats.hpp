@@ -0,0 +1,217 @@
+// pool_stats.hpp                                                    -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#ifndef INCLUDED_POOL_STATS
+#define INCLUDED_POOL_STATS
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Instrumentation of nstd::thread_pool: when compiled with
+// -DNSTD_THREAD_POOL_STATS=1 each worker counts the jobs it ran, the time
+// it spent running jobs and waiting for jobs, the jobs it stole and
+// submitted, the exceptions it caught, and the high-water mark of its
+// queue. Threads which aren't workers of the pool (including their use of
+// the shared queue) are accounted for in one extra set of counters. Without
+// NSTD_THREAD_POOL_STATS the counters are empty and all updates are no-ops.
+// The busy time of a job includes the time of jobs it runs while joining.
+
+#ifndef NSTD_THREAD_POOL_STATS
+#define NSTD_THREAD_POOL_STATS 0
+#endif
+
+namespace nstd {
+    struct worker_stats;
+    struct pool_stats;
+    template <bool Enabled> class pool_counters;
+
+    worker_stats operator-(worker_stats const&, worker_stats const&);
+    pool_stats operator-(pool_stats const&, pool_stats const&);
+    std::ostream& operator<< (std::ostream&, worker_stats const&);
+    std::ostream& operator<< (std::ostream&, pool_stats const&);
+}
+
+// ----------------------------------------------------------------------------
+
+struct nstd::worker_stats {
+    long jobs       = 0;
+    long busy_us    = 0;
+    long idle_us    = 0;
+    long max_depth  = 0;
+    long steals     = 0;
+    long submits    = 0;
+    long exceptions = 0;
+
+    worker_stats& operator+= (worker_stats const& other) {
+        this->jobs       += other.jobs;
+        this->busy_us    += other.busy_us;
+        this->idle_us    += other.idle_us;
+        this->max_depth   = std::max(this->max_depth, other.max_depth);
+        this->steals     += other.steals;
+        this->submits    += other.submits;
+        this->exceptions += other.exceptions;
+        return *this;
+    }
+};
+
+struct nstd::pool_stats {
+    bool                      enabled = false;
+    std::vector<worker_stats> workers;
+    worker_stats              external;
+
+    worker_stats total() const {
+        worker_stats rc(this->external);
+        for (auto const& w: this->workers) {
+            rc += w;
+        }
+        return rc;
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+template <>
+class nstd::pool_counters<false> {
+public:
+    using time_point = int;
+
+    static time_point now() { return 0; }
+    void busy(time_point) {}
+    void idle(time_point) {}
+    void queue_depth(std::size_t) {}
+    void steal() {}
+    void submit(int) {}
+    void exception() {}
+    nstd::worker_stats snapshot() const { return nstd::worker_stats(); }
+};
+
+// ----------------------------------------------------------------------------
+
+template <>
+class nstd::pool_counters<true> {
+private:
+    using clock = std::chrono::steady_clock;
+
+    std::atomic<long> d_jobs{0};
+    std::atomic<long> d_busy{0};
+    std::atomic<long> d_idle{0};
+    std::atomic<long> d_max_depth{0};
+    std::atomic<long> d_steals{0};
+    std::atomic<long> d_submits{0};
+    std::atomic<long> d_exceptions{0};
+
+    static void add(std::atomic<long>& counter, long value) {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    }
+    static long since(clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+    }
+
+public:
+    using time_point = clock::time_point;
+
+    static time_point now() { return clock::now(); }
+    void busy(time_point start) {
+        add(this->d_jobs, 1);
+        add(this->d_busy, since(start));
+    }
+    void idle(time_point start) { add(this->d_idle, since(start)); }
+    void queue_depth(std::size_t depth) {
+        // may be called concurrently, e.g., by external submitters
+        long current(this->d_max_depth.load(std::memory_order_relaxed));
+        while (current < long(depth)
+               && !this->d_max_depth.compare_exchange_weak(current, long(depth),
+                                                          std::memory_order_relaxed)) {
+        }
+    }
+    void steal() { add(this->d_steals, 1); }
+    void submit(int count) { add(this->d_submits, count); }
+    void exception() { add(this->d_exceptions, 1); }
+
+    nstd::worker_stats snapshot() const {
+        nstd::worker_stats rc;
+        rc.jobs       = this->d_jobs.load(std::memory_order_relaxed);
+        rc.busy_us    = this->d_busy.load(std::memory_order_relaxed) / 1000;
+        rc.idle_us    = this->d_idle.load(std::memory_order_relaxed) / 1000;
+        rc.max_depth  = this->d_max_depth.load(std::memory_order_relaxed);
+        rc.steals     = this->d_steals.load(std::memory_order_relaxed);
+        rc.submits    = this->d_submits.load(std::memory_order_relaxed);
+        rc.exceptions = this->d_exceptions.load(std::memory_order_relaxed);
+        return rc;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// The difference of two snapshots gives the activity in between (except
+// for the high-water mark which is taken from the later snapshot).
+
+inline nstd::worker_stats nstd::operator-(nstd::worker_stats const& w1,
+                                          nstd::worker_stats const& w0) {
+    nstd::worker_stats rc;
+    rc.jobs       = w1.jobs - w0.jobs;
+    rc.busy_us    = w1.busy_us - w0.busy_us;
+    rc.idle_us    = w1.idle_us - w0.idle_us;
+    rc.max_depth  = w1.max_depth;
+    rc.steals     = w1.steals - w0.steals;
+    rc.submits    = w1.submits - w0.submits;
+    rc.exceptions = w1.exceptions - w0.exceptions;
+    return rc;
+}
+
+inline nstd::pool_stats nstd::operator-(nstd::pool_stats const& s1,
+                                        nstd::pool_stats const& s0) {
+    nstd::pool_stats rc(s1);
+    for (std::size_t i(0); i != rc.workers.size() && i != s0.workers.size(); ++i) {
+        rc.workers[i] = s1.workers[i] - s0.workers[i];
+    }
+    rc.external = s1.external - s0.external;
+    return rc;
+}
+
+inline std::ostream& nstd::operator<< (std::ostream& out, nstd::worker_stats const& stats) {
+    return out << "jobs=" << stats.jobs << ' '
+               << "busy=" << stats.busy_us << "us "
+               << "idle=" << stats.idle_us << "us "
+               << "max_depth=" << stats.max_depth << ' '
+               << "steals=" << stats.steals << ' '
+               << "submits=" << stats.submits << ' '
+               << "exceptions=" << stats.exceptions;
+}
+
+inline std::ostream& nstd::operator<< (std::ostream& out, nstd::pool_stats const& stats) {
+    if (!stats.enabled) {
+        return out << "stats disabled";
+    }
+    return out << stats.total();
+}
+
+// ----------------------------------------------------------------------------
+
+#endif
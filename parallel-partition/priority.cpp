@@ -0,0 +1,132 @@
+// priority.cpp                                                      -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#include "latch.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Measures the latency of small jobs, i.e., the time from enqueuing a job
+// until it starts executing, while the pool is saturated with bulk jobs:
+// each bulk job busies its worker for a while and enqueues its successor,
+// keeping a deep backlog of normal priority jobs. With work stealing the
+// successors go to the workers' own deques which are processed before the
+// shared queue, i.e., only high priority jobs are measured: a normal job
+// from outside the pool wouldn't get to run until the load stops.
+
+using clock_type = std::chrono::steady_clock;
+
+struct bulk_load {
+    nstd::thread_pool& d_pool;
+    std::atomic<bool>  d_running;
+    std::atomic<int>   d_active;
+    std::atomic<long>  d_done;
+
+    bulk_load(nstd::thread_pool& pool, int backlog)
+        : d_pool(pool)
+        , d_running(true)
+        , d_active(backlog)
+        , d_done(0) {
+        pool.enqueue_bulk(backlog, [this](int){ this->run(); });
+    }
+    void run() {
+        auto end = clock_type::now() + std::chrono::microseconds(20);
+        while (clock_type::now() < end) {
+        }
+        ++this->d_done;
+        if (this->d_running) {
+            this->d_pool.enqueue_job([this]{ this->run(); });
+        }
+        else {
+            --this->d_active;
+        }
+    }
+    ~bulk_load() {
+        this->d_running = false;
+        while (this->d_active) {
+            std::this_thread::yield();
+        }
+    }
+};
+
+void measure(std::string const& name, nstd::thread_pool::mode mode,
+             nstd::thread_pool::priority priority, int workers) {
+    constexpr int samples = 200;
+    nstd::thread_pool pool(workers, mode);
+    pool.start();
+    bulk_load load(pool, 1000);
+
+    std::vector<clock_type::duration> latencies;
+    latencies.reserve(samples);
+    for (int i(0); i != samples; ++i) {
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+        nstd::latch          latch(1);
+        clock_type::duration latency;
+        auto start = clock_type::now();
+        pool.enqueue_job([&]{
+                latency = clock_type::now() - start;
+                latch.arrive();
+            }, priority);
+        latch.wait();
+        latencies.push_back(latency);
+    }
+    long done(load.d_done);
+    std::sort(latencies.begin(), latencies.end());
+    auto us = [](clock_type::duration d){
+        return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    };
+    std::cout << std::setw(30) << name << ' '
+              << "workers=" << std::setw(3) << workers << ' '
+              << "median=" << std::setw(8) << us(latencies[samples / 2]) << "us "
+              << "p99=" << std::setw(8) << us(latencies[samples * 99 / 100]) << "us "
+              << "bulk=" << std::setw(8) << done << ' '
+              << '\n' << std::flush;
+}
+
+// ----------------------------------------------------------------------------
+
+int main() {
+    try {
+        using mode     = nstd::thread_pool::mode;
+        using priority = nstd::thread_pool::priority;
+        int hardware(std::max(1u, std::thread::hardware_concurrency()));
+        for (int workers: { 1, hardware }) {
+            measure("shared_queue normal", mode::shared_queue, priority::normal, workers);
+            measure("shared_queue high", mode::shared_queue, priority::high, workers);
+            measure("work_stealing high", mode::work_stealing, priority::high, workers);
+        }
+    }
+    catch (std::exception const& ex) {
+        std::cerr << "ERROR: " << ex.what() << '\n';
+    }
+}
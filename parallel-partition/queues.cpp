@@ -0,0 +1,90 @@
+// queues.cpp                                                        -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#include "job_queue.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Measures the throughput of the shared queue backends: a number of external
+// producer threads concurrently submit independent (empty) jobs to a pool
+// until all of them are processed. External producers take job nodes from
+// the lock-free free list of the pool's job_slab: with the mpmc_job_queue a
+// submission only locks a mutex when the ring overflows or a worker sleeps.
+
+template <typename Pool>
+void measure(std::string const& name, int workers, int producers) {
+    using clock = std::chrono::steady_clock;
+    constexpr int jobs = 100000;
+
+    Pool pool(workers);
+    pool.start();
+    std::atomic<int> done(0);
+    std::vector<std::thread> threads;
+
+    auto start = clock::now();
+    for (int i(0); i != producers; ++i) {
+        threads.emplace_back([&]{
+                for (int j(0); j != jobs; ++j) {
+                    pool.enqueue_job([&done]{ ++done; });
+                }
+            });
+    }
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    while (done != producers * jobs) {
+        std::this_thread::yield();
+    }
+    auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+    std::cout << std::setw(20) << name << ' '
+              << "workers=" << std::setw(3) << workers << ' '
+              << "producers=" << std::setw(3) << producers << ' '
+              << std::setw(8) << time.count() / (producers * jobs) << "ns/job"
+              << '\n' << std::flush;
+}
+
+// ----------------------------------------------------------------------------
+
+int main() {
+    try {
+        int hardware(std::max(1u, std::thread::hardware_concurrency()));
+        for (int producers: { 1, 2, 4, 8 }) {
+            measure<nstd::basic_thread_pool<nstd::locked_job_queue>>("locked", hardware, producers);
+            measure<nstd::basic_thread_pool<nstd::mpmc_job_queue<>>>("mpmc", hardware, producers);
+        }
+    }
+    catch (std::exception const& ex) {
+        std::cerr << "ERROR: " << ex.what() << '\n';
+    }
+}
@@ -0,0 +1,183 @@
+// scratch.hpp                                                       -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#ifndef INCLUDED_SCRATCH
+#define INCLUDED_SCRATCH
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Each thread has a scratch arena for temporary buffers: memory is obtained
+// by bumping an offset into a cache-aligned buffer and given back by
+// resetting the offset to an earlier mark. nstd::thread_pool marks the arena
+// before each job and resets it afterwards, i.e., a job can use
+// this_worker::scratch() freely and the memory stays valid until the job
+// returns. Outside of jobs, or to give memory back earlier, a scratch_scope
+// does the same.
+//
+// Requests not fitting into the buffer are allocated separately and freed
+// when released. Once the arena is completely released the buffer grows to
+// also accommodate these, i.e., after a warm-up phase the global allocator
+// isn't used at all.
+
+namespace nstd {
+    class scratch_arena;
+    class scratch_scope;
+
+    namespace this_worker {
+        nstd::scratch_arena& arena();
+        void* scratch(std::size_t bytes, std::size_t alignment = 64u);
+        template <typename T>
+        T* scratch_array(std::size_t count);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+class nstd::scratch_arena {
+public:
+    class position {
+    private:
+        friend class scratch_arena;
+        std::size_t d_used;
+        std::size_t d_overflow;
+        position(std::size_t used, std::size_t overflow)
+            : d_used(used)
+            , d_overflow(overflow) {
+        }
+    };
+
+private:
+    static constexpr std::size_t cache_line   = 64u;
+    static constexpr std::size_t initial_size = 64u * 1024u;
+
+    std::unique_ptr<char[]>              d_storage;
+    char*                                d_buffer;
+    std::size_t                          d_size;
+    std::size_t                          d_used;
+    std::vector<std::unique_ptr<char[]>> d_overflow;
+    std::size_t                          d_overflow_size;
+
+    static char* align(char* pointer, std::size_t alignment) {
+        std::uintptr_t value(reinterpret_cast<std::uintptr_t>(pointer));
+        return pointer + ((alignment - value % alignment) % alignment);
+    }
+    void grow() {
+        std::size_t size(std::max(std::size_t(initial_size), 2u * (this->d_size + this->d_overflow_size)));
+        this->d_overflow_size = 0u;
+        this->d_storage.reset();
+        this->d_storage.reset(new char[size + cache_line]);
+        this->d_buffer = align(this->d_storage.get(), cache_line);
+        this->d_size   = size;
+    }
+
+public:
+    scratch_arena()
+        : d_buffer(nullptr)
+        , d_size(0u)
+        , d_used(0u)
+        , d_overflow_size(0u) {
+    }
+    scratch_arena(scratch_arena&) = delete;
+    void operator=(scratch_arena&) = delete;
+
+    std::size_t capacity() const { return this->d_size; }
+    position mark() const { return position(this->d_used, this->d_overflow.size()); }
+    void release(position mark) {
+        this->d_used = mark.d_used;
+        this->d_overflow.resize(mark.d_overflow);
+        if (this->d_used == 0u && this->d_overflow.empty() && this->d_overflow_size) {
+            this->grow();
+        }
+    }
+
+    void* allocate(std::size_t bytes, std::size_t alignment = cache_line) {
+        std::size_t offset((this->d_used + alignment - 1u) / alignment * alignment);
+        if (this->d_buffer && offset + bytes <= this->d_size) {
+            this->d_used = offset + bytes;
+            return this->d_buffer + offset;
+        }
+        this->d_overflow.emplace_back(new char[bytes + alignment]);
+        this->d_overflow_size += bytes + alignment;
+        return align(this->d_overflow.back().get(), alignment);
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+class nstd::scratch_scope {
+private:
+    nstd::scratch_arena&          d_arena;
+    nstd::scratch_arena::position d_mark;
+
+public:
+    scratch_scope()
+        : d_arena(nstd::this_worker::arena())
+        , d_mark(this->d_arena.mark()) {
+    }
+    scratch_scope(scratch_scope&) = delete;
+    void operator=(scratch_scope&) = delete;
+    ~scratch_scope() { this->d_arena.release(this->d_mark); }
+
+    // Value-initialized objects which are never destroyed.
+    template <typename T>
+    T* allocate(std::size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "objects in scratch memory are not destroyed");
+        T* rc(static_cast<T*>(this->d_arena.allocate(count * sizeof(T),
+                                                     std::max(alignof(T), std::size_t(64u)))));
+        for (std::size_t i(0); i != count; ++i) {
+            new(rc + i) T();
+        }
+        return rc;
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+inline nstd::scratch_arena& nstd::this_worker::arena() {
+    thread_local nstd::scratch_arena rc;
+    return rc;
+}
+
+inline void* nstd::this_worker::scratch(std::size_t bytes, std::size_t alignment) {
+    return nstd::this_worker::arena().allocate(bytes, alignment);
+}
+
+template <typename T>
+T* nstd::this_worker::scratch_array(std::size_t count) {
+    return static_cast<T*>(nstd::this_worker::scratch(count * sizeof(T),
+                                                      std::max(alignof(T), std::size_t(64u))));
+}
+
+// ----------------------------------------------------------------------------
+
+#endif
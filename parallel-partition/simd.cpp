@@ -0,0 +1,130 @@
+// simd.cpp                                                          -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#include "simd_kernel.hpp"
+#include "cpu_features.hpp"
+#include "parallel_partition.hpp"
+#include "timer.hpp"
+#include <algorithm>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Compares the partition kernels on threshold predicates for the element
+// types with a vectorised classification: once sequentially to see the
+// kernels on their own and once using parallel_partition2. The simd_kernel
+// is run for each level of vector instructions supported by the CPU or
+// only for the levels given using --simd=<level> with <level> being one of
+// scalar, avx2, or avx512.
+
+template <typename Kernel, typename T>
+void measure(std::string const& type, std::string const& name, Kernel kernel,
+             std::vector<T> const& data, int divisor, bool parallel) {
+    nstd::thread_pool& pool(nstd::default_pool());
+    nstd::less_than<T> predicate{T(data.size() / divisor)};
+    std::vector<T>     copy(data);
+    utility::timer     timer;
+    timer.start();
+    auto it = parallel
+        ? nstd::parallel_partition2<nstd::block_manager_relaxed, nstd::thread_pool, Kernel>(pool)(
+            copy.begin(), copy.end(), predicate)
+        : blocked_partition(copy.begin(), copy.end(), predicate, kernel);
+    auto time = timer.stop();
+    bool rc = std::is_partitioned(copy.begin(), copy.end(), predicate)
+        && it == std::partition_point(copy.begin(), copy.end(), predicate);
+    std::cout << std::setw(10) << type << ' '
+              << std::setw(20) << name << ' '
+              << (parallel? "parallel  ": "sequential") << ' '
+              << "divisor=" << std::setw(4) << divisor << ' '
+              << (rc? "passed": "\x1b[31mfailed\x1b[0m") << ' '
+              << time
+              << '\n' << std::flush;
+}
+
+// ----------------------------------------------------------------------------
+
+template <typename T>
+void run_tests(std::string const& type, std::size_t size,
+               std::vector<nstd::simd_level> const& levels) {
+    std::minstd_rand rnd(0);
+    std::vector<T>   data;
+    std::generate_n(std::back_inserter(data), size, [size, &rnd]{ return T(rnd() % size); });
+
+    for (int divisor: { 2, 10, 100 }) {
+        for (bool parallel: { false, true }) {
+            measure(type, "branching_kernel", nstd::branching_kernel(), data, divisor, parallel);
+            measure(type, "branchless_kernel", nstd::branchless_kernel(), data, divisor, parallel);
+            for (auto level: levels) {
+                nstd::cpu_features::instance().select(level);
+                measure(type, std::string("simd_kernel/") + nstd::to_string(level),
+                        nstd::simd_kernel(), data, divisor, parallel);
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+int main(int ac, char* av[]) {
+    try {
+        nstd::cpu_features&           features(nstd::cpu_features::instance());
+        std::vector<nstd::simd_level> levels;
+        for (int i(1); i != ac; ++i) {
+            std::string      arg(av[i]);
+            nstd::simd_level level;
+            if (arg.compare(0, 7, "--simd=") != 0 || !nstd::from_string(arg.substr(7), level)) {
+                std::cerr << "usage: " << av[0] << " [--simd=scalar|avx2|avx512]...\n";
+                return 1;
+            }
+            if (features.supported() < level) {
+                std::cerr << "simd level " << nstd::to_string(level) << " isn't supported\n";
+                return 1;
+            }
+            levels.push_back(level);
+        }
+        if (levels.empty()) {
+            for (auto level: { nstd::simd_level::scalar, nstd::simd_level::avx2, nstd::simd_level::avx512 }) {
+                if (level <= features.supported()) {
+                    levels.push_back(level);
+                }
+            }
+        }
+        std::cout << "supported simd level: " << nstd::to_string(features.supported()) << '\n';
+        for (std::size_t size: { 100000u, 10000000u }) {
+            std::cout << "--- size=" << size << '\n';
+            run_tests<int>("int", size, levels);
+            run_tests<long long>("long long", size, levels);
+            run_tests<float>("float", size, levels);
+            run_tests<double>("double", size, levels);
+        }
+    }
+    catch (std::exception const& ex) {
+        std::cerr << "ERROR: " << ex.what() << '\n';
+    }
+}
@@ -0,0 +1,358 @@
+// simd_kernel.hpp                                                   -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#ifndef INCLUDED_SIMD_KERNEL
+#define INCLUDED_SIMD_KERNEL
+
+#include "partition_kernel.hpp"
+#include "cpu_features.hpp"
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
+// ----------------------------------------------------------------------------
+// The predicates used when partitioning for a quick sort are mostly of the
+// form value < pivot. When such a predicate is spelled less_than<T>{pivot}
+// and the elements are contiguous arithmetic values, the simd_kernel
+// classifies 8 or 16 elements with one comparison: the resulting mask
+// selects the offsets of the misplaced elements, using a permutation table
+// with AVX2 and a compress with AVX-512. Both variants are compiled for
+// their instruction set independent of the compiler flags and the one to
+// use is chosen at run-time according to nstd::cpu_features. Other
+// predicates, iterators, and CPUs without these instruction sets use the
+// scalar classification of the branchless_kernel. The elements are still
+// swapped one pair at a time.
+
+namespace nstd {
+    template <typename T> struct less_than;
+    template <typename Compare, typename T> struct compare_with_pivot;
+    template <typename Compare, typename T>
+    nstd::compare_with_pivot<Compare, T> pivot_predicate(Compare compare, T pivot);
+    template <typename T>
+    nstd::less_than<T> pivot_predicate(std::less<T>, T pivot);
+    template <typename T>
+    nstd::less_than<T> pivot_predicate(std::less<>, T pivot);
+    template <typename RndIt> struct is_contiguous_iterator;
+    template <typename T> struct simd_lane;
+    struct simd_classifier;
+    using simd_kernel = nstd::chunked_kernel<nstd::simd_classifier>;
+}
+
+// ----------------------------------------------------------------------------
+
+template <typename T>
+struct nstd::less_than {
+    T pivot;
+    bool operator()(T const& value) const { return value < this->pivot; }
+};
+
+// ----------------------------------------------------------------------------
+// pivot_predicate(compare, pivot) yields the predicate to partition around
+// the pivot for a sort using compare: a less_than<T> for std::less to allow
+// the vectorised classification.
+
+template <typename Compare, typename T>
+struct nstd::compare_with_pivot {
+    Compare compare;
+    T       pivot;
+    template <typename Value>
+    bool operator()(Value const& value) const { return this->compare(value, this->pivot); }
+};
+
+template <typename Compare, typename T>
+nstd::compare_with_pivot<Compare, T> nstd::pivot_predicate(Compare compare, T pivot) {
+    return nstd::compare_with_pivot<Compare, T>{ compare, pivot };
+}
+
+template <typename T>
+nstd::less_than<T> nstd::pivot_predicate(std::less<T>, T pivot) {
+    return nstd::less_than<T>{ pivot };
+}
+
+template <typename T>
+nstd::less_than<T> nstd::pivot_predicate(std::less<>, T pivot) {
+    return nstd::less_than<T>{ pivot };
+}
+
+// ----------------------------------------------------------------------------
+// Without a standard way to detect contiguous iterators only pointers and
+// the iterators of std::vector are recognized.
+
+template <typename RndIt>
+struct nstd::is_contiguous_iterator
+    : std::is_pointer<RndIt> {
+};
+
+namespace nstd {
+    template <template <typename, typename> class Iterator, typename T, typename Allocator>
+    struct is_contiguous_iterator<Iterator<T*, std::vector<T, Allocator>>>
+        : std::is_same<Iterator<T*, std::vector<T, Allocator>>,
+                       typename std::vector<T, Allocator>::iterator> {
+    };
+}
+
+// ----------------------------------------------------------------------------
+// The type of the vector lanes used to compare values of type T or void if
+// there is no suitable comparison.
+
+template <typename T>
+struct nstd::simd_lane {
+    using type = typename std::conditional<
+        std::is_same<T, float>::value || std::is_same<T, double>::value, T,
+        typename std::conditional<
+            std::is_integral<T>::value && std::is_signed<T>::value && sizeof(T) == 4, std::int32_t,
+            typename std::conditional<
+                std::is_integral<T>::value && std::is_signed<T>::value && sizeof(T) == 8, std::int64_t,
+                void>::type>::type>::type;
+};
+
+// ----------------------------------------------------------------------------
+
+struct nstd::simd_classifier {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    template <bool Satisfying, typename RndIt, typename Predicate>
+    static int classify(RndIt it, int size, unsigned char* offsets,
+                        Predicate& predicate) {
+        return nstd::scalar_classifier::classify<Satisfying>(it, size, offsets, predicate);
+    }
+    template <bool Satisfying, typename RndIt, typename T>
+    static int classify(RndIt it, int size, unsigned char* offsets,
+                        nstd::less_than<T>& predicate) {
+        using value_type = typename std::iterator_traits<RndIt>::value_type;
+        using lane_type  = typename nstd::simd_lane<T>::type;
+        return simd_classifier::classify_less<Satisfying>(
+            it, size, offsets, predicate,
+            std::integral_constant<bool, enabled
+                                   && nstd::is_contiguous_iterator<RndIt>::value
+                                   && std::is_same<value_type, T>::value
+                                   && !std::is_void<lane_type>::value>());
+    }
+
+private:
+    template <bool Satisfying, typename RndIt, typename T>
+    static int classify_less(RndIt it, int size, unsigned char* offsets,
+                             nstd::less_than<T>& predicate, std::false_type) {
+        return nstd::scalar_classifier::classify<Satisfying>(it, size, offsets, predicate);
+    }
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    template <bool Satisfying, typename RndIt, typename T>
+    static int classify_less(RndIt it, int size, unsigned char* offsets,
+                             nstd::less_than<T>& predicate, std::true_type) {
+        using lane_type = typename nstd::simd_lane<T>::type;
+        int i(0), count(0);
+        if (size != 0) {
+            // the lanes are only accessed using vector loads
+            lane_type const* data(reinterpret_cast<lane_type const*>(&*it));
+            lane_type        pivot(predicate.pivot);
+            switch (nstd::cpu_features::instance().selected()) {
+            case nstd::simd_level::avx512:
+                count = simd_classifier::classify_avx512<Satisfying>(data, i, size, offsets, pivot);
+                break;
+            case nstd::simd_level::avx2:
+                count = simd_classifier::classify_avx2<Satisfying>(data, i, size, offsets, pivot);
+                break;
+            case nstd::simd_level::scalar:
+                break;
+            }
+        }
+        for (; i != size; ++i) {
+            offsets[count] = static_cast<unsigned char>(i);
+            count += predicate(it[i]) == Satisfying;
+        }
+        return count;
+    }
+
+    // ------------------------------------------------------------------------
+    // The mask of a comparison selects the offsets to be stored using a
+    // compress of a vector of lane indices.
+
+    template <bool Satisfying>
+    __attribute__((target("avx512f")))
+    static int store_avx512(__mmask16 mask, __m512i offset, unsigned char* offsets, int count) {
+        mask = Satisfying? mask: __mmask16(~mask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(offsets + count),
+                         _mm512_maskz_cvtepi32_epi8(__mmask16(-1),
+                                                    _mm512_maskz_compress_epi32(mask, offset)));
+        return count + __builtin_popcount(mask);
+    }
+    template <bool Satisfying>
+    __attribute__((target("avx512f")))
+    static int store_avx512(__mmask8 mask, __m512i offset, unsigned char* offsets, int count) {
+        mask = Satisfying? mask: __mmask8(~mask);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(offsets + count),
+                         _mm512_maskz_cvtepi64_epi8(__mmask8(-1),
+                                                    _mm512_maskz_compress_epi64(mask, offset)));
+        return count + __builtin_popcount(mask);
+    }
+
+    template <bool Satisfying>
+    __attribute__((target("avx512f")))
+    static int classify_avx512(std::int32_t const* data, int& i, int size,
+                              unsigned char* offsets, std::int32_t pivot) {
+        __m512i p(_mm512_set1_epi32(pivot));
+        __m512i offset(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+        int count(0);
+        for (; i + 16 <= size; i += 16, offset = _mm512_add_epi32(offset, _mm512_set1_epi32(16))) {
+            __m512i v(_mm512_loadu_si512(data + i));
+            count = store_avx512<Satisfying>(_mm512_cmplt_epi32_mask(v, p), offset, offsets, count);
+        }
+        return count;
+    }
+    template <bool Satisfying>
+    __attribute__((target("avx512f")))
+    static int classify_avx512(float const* data, int& i, int size,
+                              unsigned char* offsets, float pivot) {
+        __m512  p(_mm512_set1_ps(pivot));
+        __m512i offset(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+        int count(0);
+        for (; i + 16 <= size; i += 16, offset = _mm512_add_epi32(offset, _mm512_set1_epi32(16))) {
+            __m512 v(_mm512_loadu_ps(data + i));
+            count = store_avx512<Satisfying>(_mm512_cmp_ps_mask(v, p, _CMP_LT_OQ), offset, offsets, count);
+        }
+        return count;
+    }
+    template <bool Satisfying>
+    __attribute__((target("avx512f")))
+    static int classify_avx512(std::int64_t const* data, int& i, int size,
+                              unsigned char* offsets, std::int64_t pivot) {
+        __m512i p(_mm512_set1_epi64(pivot));
+        __m512i offset(_mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7));
+        int count(0);
+        for (; i + 8 <= size; i += 8, offset = _mm512_add_epi64(offset, _mm512_set1_epi64(8))) {
+            __m512i v(_mm512_loadu_si512(data + i));
+            count = store_avx512<Satisfying>(_mm512_cmplt_epi64_mask(v, p), offset, offsets, count);
+        }
+        return count;
+    }
+    template <bool Satisfying>
+    __attribute__((target("avx512f")))
+    static int classify_avx512(double const* data, int& i, int size,
+                              unsigned char* offsets, double pivot) {
+        __m512d p(_mm512_set1_pd(pivot));
+        __m512i offset(_mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7));
+        int count(0);
+        for (; i + 8 <= size; i += 8, offset = _mm512_add_epi64(offset, _mm512_set1_epi64(8))) {
+            __m512d v(_mm512_loadu_pd(data + i));
+            count = store_avx512<Satisfying>(_mm512_cmp_pd_mask(v, p, _CMP_LT_OQ), offset, offsets, count);
+        }
+        return count;
+    }
+
+    // ------------------------------------------------------------------------
+    // The mask of a comparison indexes a table holding the indices of its
+    // set bits as 8 bytes which are stored after adding the group's offset.
+
+    struct table {
+        std::uint64_t entries[256];
+        constexpr table(): entries() {
+            for (int mask(0); mask != 256; ++mask) {
+                for (int bit(0), count(0); bit != 8; ++bit) {
+                    if (mask & (1 << bit)) {
+                        this->entries[mask] |= std::uint64_t(bit) << (8 * count++);
+                    }
+                }
+            }
+        }
+    };
+
+    template <bool Satisfying, int Lanes>
+    __attribute__((target("avx2")))
+    static int store_avx2(int mask, int i, unsigned char* offsets, int count) {
+        static constexpr table indices{};
+        mask = Satisfying? mask: ~mask & ((1 << Lanes) - 1);
+        __m128i entry(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(indices.entries + mask)));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(offsets + count),
+                         _mm_add_epi8(entry, _mm_set1_epi8(static_cast<char>(i))));
+        return count + __builtin_popcount(mask);
+    }
+
+    template <bool Satisfying>
+    __attribute__((target("avx2")))
+    static int classify_avx2(std::int32_t const* data, int& i, int size,
+                              unsigned char* offsets, std::int32_t pivot) {
+        __m256i p(_mm256_set1_epi32(pivot));
+        int count(0);
+        for (; i + 8 <= size; i += 8) {
+            __m256i v(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + i)));
+            int mask(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(p, v))));
+            count = store_avx2<Satisfying, 8>(mask, i, offsets, count);
+        }
+        return count;
+    }
+    template <bool Satisfying>
+    __attribute__((target("avx2")))
+    static int classify_avx2(float const* data, int& i, int size,
+                              unsigned char* offsets, float pivot) {
+        __m256 p(_mm256_set1_ps(pivot));
+        int count(0);
+        for (; i + 8 <= size; i += 8) {
+            __m256 v(_mm256_loadu_ps(data + i));
+            int mask(_mm256_movemask_ps(_mm256_cmp_ps(v, p, _CMP_LT_OQ)));
+            count = store_avx2<Satisfying, 8>(mask, i, offsets, count);
+        }
+        return count;
+    }
+    template <bool Satisfying>
+    __attribute__((target("avx2")))
+    static int classify_avx2(std::int64_t const* data, int& i, int size,
+                              unsigned char* offsets, std::int64_t pivot) {
+        __m256i p(_mm256_set1_epi64x(pivot));
+        int count(0);
+        for (; i + 4 <= size; i += 4) {
+            __m256i v(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + i)));
+            int mask(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(p, v))));
+            count = store_avx2<Satisfying, 4>(mask, i, offsets, count);
+        }
+        return count;
+    }
+    template <bool Satisfying>
+    __attribute__((target("avx2")))
+    static int classify_avx2(double const* data, int& i, int size,
+                              unsigned char* offsets, double pivot) {
+        __m256d p(_mm256_set1_pd(pivot));
+        int count(0);
+        for (; i + 4 <= size; i += 4) {
+            __m256d v(_mm256_loadu_pd(data + i));
+            int mask(_mm256_movemask_pd(_mm256_cmp_pd(v, p, _CMP_LT_OQ)));
+            count = store_avx2<Satisfying, 4>(mask, i, offsets, count);
+        }
+        return count;
+    }
+#endif
+};
+
+// ----------------------------------------------------------------------------
+
+#endif
@@ -26,14 +26,16 @@
 #ifndef INCLUDED_SLIDES_PARTITION
 #define INCLUDED_SLIDES_PARTITION
 
-#include "latch.hpp"
+#include "executor.hpp"
 #include "not_fn.hpp"
+#include "partition_kernel.hpp"
 #include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <deque>
 #include <functional>
 #include <iostream>
+#include <iterator>
 #include <mutex>
 #include <thread>
 #include <tuple>
@@ -51,6 +53,7 @@ class Block {
 public:
     Block(): d_begin(), d_current(), d_end() {}
     Block(RndIt b, RndIt e): d_begin(b), d_current(b), d_end(e) {}
+    Block(RndIt b, RndIt c, RndIt e): d_begin(b), d_current(c), d_end(e) {}
     bool empty() const { return this->d_current == this->d_end; }
     auto operator*() const -> decltype(*this->d_current) {
         return *this->d_current;
@@ -80,6 +83,23 @@ std::pair<Blk, Blk> block(Blk f, Blk b, Predicate pred)
     }
 }
 
+// Process the blocks using a partition kernel (see partition_kernel.hpp);
+// the branching kernel is the loop above.
+
+template <typename It, typename Predicate>
+std::pair<Block<It>, Block<It>> block(Block<It> f, Block<It> b, Predicate pred,
+                                      nstd::branching_kernel) {
+    return block(f, b, pred);
+}
+
+template <typename It, typename Predicate, typename Kernel>
+std::pair<Block<It>, Block<It>> block(Block<It> f, Block<It> b, Predicate pred,
+                                      Kernel kernel) {
+    auto r = kernel(f.cur(), f.end(), b.cur(), b.end(), pred);
+    return std::make_pair(Block<It>(f.begin(), r.first, f.end()),
+                          Block<It>(b.begin(), r.second, b.end()));
+}
+
 template <typename It, typename Pred>
 It clean_up(Block<It> f, Block<It> b, Pred pred) {
     if (b.empty()) {
@@ -93,20 +113,21 @@ It clean_up(Block<It> f, Block<It> b, Pred pred) {
 
 template <typename RndIt, int Size = 4096>
 class BlockQueue {
+    using diff_t = typename std::iterator_traits<RndIt>::difference_type;
     RndIt beg, end;
-    static constexpr int bs = Size;
-    std::atomic<int> size, f_off{0}, b_off{0};
+    static constexpr diff_t bs = Size;
+    std::atomic<diff_t> size, f_off{0}, b_off{0};
 public:
     BlockQueue(RndIt b, RndIt e): beg(b), end(e), size(e-b) {}
     Block<RndIt> front() {
         auto s  = size.fetch_sub(bs); 
-        s = std::min(std::max(0, s), bs);
+        s = std::min(std::max(diff_t(0), s), diff_t(bs));
         auto off = f_off.fetch_add(s);
         return Block<RndIt>(beg + off, beg + off + s);
     }
     Block<RndIt> back() {
         auto s = size.fetch_sub(bs); 
-        s = std::min(std::max(0, s), bs);
+        s = std::min(std::max(diff_t(0), s), diff_t(bs));
         auto off = b_off.fetch_add(s);
         return Block<RndIt>(end - off - s, end - off);
     }
@@ -115,14 +136,14 @@ public:
 
 // ----------------------------------------------------------------------------
 
-template <typename RndIt, typename Predicate>
-RndIt blocked(RndIt begin, RndIt end, Predicate pred) {
+template <typename RndIt, typename Predicate, typename Kernel = nstd::branching_kernel>
+RndIt blocked(RndIt begin, RndIt end, Predicate pred, Kernel kernel = Kernel()) {
     BlockQueue<RndIt> q(begin, end);
     Block<RndIt>      f, b;
     while (true) {
         if (f.empty() && (f = q.front()).empty()) { break; }
         if (b.empty() && (b = q.back()).empty()) { break; }
-        std::tie(f, b) = block(f, b, pred);
+        std::tie(f, b) = block(f, b, pred, kernel);
     }
     return clean_up(f, b, pred);
 }
@@ -175,6 +196,7 @@ public:
         std::lock_guard<std::mutex> kerberos(this->d_mutex);
         return this->d_threads.size();
     }
+    int thread_count() const { return int(this->size()); }
 };
 
 // ----------------------------------------------------------------------------
@@ -188,29 +210,35 @@ void swap_ranges_helper(RndIt1 beg1, RndIt1 end1, RndIt2 beg2) {
 
 // ----------------------------------------------------------------------------
 
-template <typename RndIt, typename Predicate>
-RndIt blocked(thread_pool& p, RndIt begin, RndIt end, Predicate pred) {
+// Any executor can be used (see executor.hpp), e.g., ::thread_pool or
+// nstd::thread_pool. The partition kernel can be chosen (see
+// partition_kernel.hpp).
+
+template <typename Executor, typename RndIt, typename Predicate,
+          typename Kernel = nstd::branching_kernel>
+RndIt blocked(Executor& p, RndIt begin, RndIt end, Predicate pred, Kernel kernel = Kernel()) {
     BlockQueue<RndIt>         q(begin, end);
-    std::vector<Block<RndIt>> remain(p.size());
-    nstd::latch               l(remain.size());
+    std::vector<Block<RndIt>> remain(std::max(1, nstd::thread_count(p)));
 
-    auto job = [&q, pred](auto& remain){
-        remain = [&q, pred]()->Block<RndIt>{
+    auto job = [&q, pred, kernel](auto& remain){
+        remain = [&q, pred, kernel]()->Block<RndIt>{
             for (Block<RndIt> f, b;;) {
                 if (f.empty() && (f = q.front()).empty())
                     return  { b.cur(), std::partition(b.cur(), b.end(), pred) };
                 if (b.empty() && (b = q.back()).empty())
                     return { std::partition(f.cur(), f.end(), pred), f.end() };
-                std::tie(f, b) = block(f, b, pred);
+                std::tie(f, b) = block(f, b, pred, kernel);
             }
         }();
     };
 
-    for (auto& block: remain) {
-        p.enqueue_job([job, &l, &block](){ job(block); l.arrive(); });
-    }
-    l.wait();
+    nstd::parallel_invoke(p, int(remain.size()), [&](int i){ job(remain[i]); });
 
+    // empty leftovers have nothing to move but may start inside a range
+    // already moved past: they'd yield negative sizes below
+    remain.erase(std::remove_if(remain.begin(), remain.end(),
+                                [](auto& b){ return b.begin() == b.end(); }),
+                 remain.end());
     RndIt mid = q.midpoint();
     auto rp = std::partition(remain.begin(), remain.end(),
                              [mid](auto& b){ return b.begin() < mid; });
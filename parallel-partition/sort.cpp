@@ -28,6 +28,7 @@
 #include "parallel_sort.hpp"
 #include <algorithm>
 #include <exception>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
@@ -65,8 +66,7 @@ void test(std::string const& name, Partition partition,
 template <typename Compare>
 void run_test(std::vector<int> const& v, Compare compare)
 {
-    nstd::thread_pool pool(128);
-    pool.start();
+    nstd::thread_pool& pool(nstd::default_pool());
 
     test("std::sort", [](auto begin, auto end, auto compare) {
             return std::sort(begin, end, compare);
@@ -74,8 +74,12 @@ void run_test(std::vector<int> const& v, Compare compare)
     test("std::stable_sort", [](auto begin, auto end, auto compare) {
             return std::stable_sort(begin, end, compare);
         }, v, compare);
+    auto stats = pool.stats();
     test("parallel_sort_with_async",
          parallel_sort_with_async<nstd::block_manager_padded_atomic>(pool), v, compare);
+    if (stats.enabled) {
+        std::cout << std::setw(60) << "pool" << ' ' << (pool.stats() - stats) << '\n';
+    }
 }
 
 // ----------------------------------------------------------------------------
@@ -90,6 +94,8 @@ void run_tests(int size)
     std::cout << "--- size=" << size << '\n';
     auto compare([](auto const& v0, auto const& v1){ return v0 < v1; });
     run_test(v, compare);
+    std::cout << "--- size=" << size << " std::less<>\n";
+    run_test(v, std::less<>());
 }
 
 // ----------------------------------------------------------------------------
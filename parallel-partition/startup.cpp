@@ -0,0 +1,101 @@
+// startup.cpp                                                       -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#include "thread_pool.hpp"
+#include "parallel_sort.hpp"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Measures the latency of short calls of parallel_sort_with_async like they
+// happen in short-lived command line tools: constructing, starting, and
+// stopping a pool per call compared to using nstd::default_pool(). The
+// first call to default_pool() includes starting it.
+
+using clock_type = std::chrono::steady_clock;
+
+template <typename Fun>
+clock_type::duration time(Fun fun) {
+    auto start = clock_type::now();
+    fun();
+    return clock_type::now() - start;
+}
+
+void report(std::string const& name, int size, clock_type::duration d) {
+    std::cout << std::setw(30) << name << ' '
+              << "size=" << std::setw(7) << size << ' '
+              << std::setw(8)
+              << std::chrono::duration_cast<std::chrono::microseconds>(d).count() << "us"
+              << '\n' << std::flush;
+}
+
+// ----------------------------------------------------------------------------
+
+int main() {
+    try {
+        constexpr int repeat = 20;
+        int hardware(std::max(1u, std::thread::hardware_concurrency()));
+        std::minstd_rand rnd(0);
+        std::vector<int> v;
+        std::generate_n(std::back_inserter(v), 100000, [&rnd]{ return rnd() % 100000; });
+
+        report("default_pool() first call", int(v.size()), time([&]{
+                    std::vector<int> c(v);
+                    parallel_sort_with_async<nstd::block_manager_relaxed>()(c.begin(), c.end(), std::less<>());
+                }));
+        for (int size: { 1000, 10000, 100000 }) {
+            std::vector<int> c;
+            auto per_call = time([&]{
+                    for (int i(0); i != repeat; ++i) {
+                        c.assign(v.begin(), v.begin() + size);
+                        nstd::thread_pool pool(hardware, nstd::thread_pool::mode::work_stealing);
+                        pool.start();
+                        parallel_sort_with_async<nstd::block_manager_relaxed> sorter(pool);
+                        sorter(c.begin(), c.end(), std::less<>());
+                    }
+                });
+            report("pool per call", size, per_call / repeat);
+            auto shared = time([&]{
+                    for (int i(0); i != repeat; ++i) {
+                        c.assign(v.begin(), v.begin() + size);
+                        parallel_sort_with_async<nstd::block_manager_relaxed>()(c.begin(), c.end(), std::less<>());
+                    }
+                });
+            report("default_pool()", size, shared / repeat);
+        }
+    }
+    catch (std::exception const& ex) {
+        std::cerr << "ERROR: " << ex.what() << '\n';
+    }
+}
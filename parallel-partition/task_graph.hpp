@@ -0,0 +1,195 @@
+// task_graph.hpp                                                    -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#ifndef INCLUDED_TASK_GRAPH
+#define INCLUDED_TASK_GRAPH
+
+#include "executor.hpp"
+#include "job.hpp"
+#include "latch.hpp"
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// An nstd::task_graph holds tasks with dependencies: a task is enqueued
+// using the executor's enqueue_job() as soon as all of its predecessors are
+// done and there is just one join for the whole graph. Thus, the stages of
+// a pipeline overlap instead of each stage waiting for the slowest job of
+// the previous stage, e.g., one side of a partition can be sorted while the
+// other side is still being partitioned.
+//
+// The tasks and their dependencies are set up before run() and need to form
+// an acyclic graph. When a task throws, the tasks depending on it are
+// skipped and run() rethrows the first exception once all other tasks are
+// done. The same graph can be run multiple times.
+
+namespace nstd {
+    class task_graph;
+}
+
+// ----------------------------------------------------------------------------
+
+class nstd::task_graph {
+private:
+    struct node {
+        nstd::job          d_job;
+        std::vector<node*> d_successors;
+        int                d_predecessors;
+        std::atomic<int>   d_pending;
+        std::atomic<bool>  d_skip;
+
+        template <typename Fun>
+        explicit node(Fun&& fun)
+            : d_job(std::forward<Fun>(fun))
+            , d_predecessors(0)
+            , d_pending(0)
+            , d_skip(false) {
+        }
+    };
+
+    std::deque<node>   d_nodes;
+    nstd::latch*       d_done;
+    std::mutex         d_kerberos;
+    std::exception_ptr d_error;
+
+    template <typename Executor>
+    void execute(Executor& executor, node* current);
+
+public:
+    class handle {
+    private:
+        friend class nstd::task_graph;
+        node* d_node;
+        explicit handle(node* n): d_node(n) {}
+
+    public:
+        handle(): d_node(nullptr) {}
+    };
+
+    task_graph(): d_done(nullptr) {}
+    task_graph(task_graph&) = delete;
+    void operator=(task_graph&) = delete;
+
+    std::size_t size() const { return this->d_nodes.size(); }
+
+    // Add the task fun which runs after the tasks predecessors.
+    template <typename Fun, typename... Predecessors>
+    handle emplace(Fun&& fun, Predecessors... predecessors) {
+        this->d_nodes.emplace_back(std::forward<Fun>(fun));
+        handle rc(&this->d_nodes.back());
+        int    expand[] = { 0, (this->precede(predecessors, rc), 0)... };
+        (void)expand;
+        return rc;
+    }
+    // Make after depend on before.
+    void precede(handle before, handle after) {
+        before.d_node->d_successors.push_back(after.d_node);
+        ++after.d_node->d_predecessors;
+    }
+
+    template <typename Executor>
+    void run(Executor& executor);
+};
+
+// ----------------------------------------------------------------------------
+// Once a task is done, the successors which became ready are enqueued
+// except for the last one which is run directly by the same thread: chains
+// of tasks don't go through the queue and the data just produced is likely
+// still in the cache. The latch is the last thing touched for a task, i.e.,
+// the graph isn't accessed after the last arrive().
+
+template <typename Executor>
+void nstd::task_graph::execute(Executor& executor, node* current) {
+    while (current) {
+        bool skip(current->d_skip.load(std::memory_order_relaxed));
+        if (!skip) {
+            try {
+                current->d_job();
+            }
+            catch (...) {
+                skip = true;
+                std::lock_guard<std::mutex> kerberos(this->d_kerberos);
+                if (!this->d_error) {
+                    this->d_error = std::current_exception();
+                }
+            }
+        }
+        node* next(nullptr);
+        for (node* successor: current->d_successors) {
+            if (skip) {
+                successor->d_skip.store(true, std::memory_order_relaxed);
+            }
+            if (successor->d_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (next) {
+                    executor.enqueue_job([this, &executor, next]{
+                            this->execute(executor, next);
+                        });
+                }
+                next = successor;
+            }
+        }
+        this->d_done->arrive();
+        current = next;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+template <typename Executor>
+void nstd::task_graph::run(Executor& executor) {
+    if (this->d_nodes.empty()) {
+        return;
+    }
+    for (node& n: this->d_nodes) {
+        n.d_pending.store(n.d_predecessors, std::memory_order_relaxed);
+        n.d_skip.store(false, std::memory_order_relaxed);
+    }
+    nstd::latch done(int(this->d_nodes.size()));
+    this->d_done  = &done;
+    this->d_error = nullptr;
+
+    for (node& n: this->d_nodes) {
+        if (n.d_predecessors == 0) {
+            node* root(&n);
+            executor.enqueue_job([this, &executor, root]{
+                    this->execute(executor, root);
+                });
+        }
+    }
+    nstd::join(executor, done);
+    this->d_done = nullptr;
+    if (this->d_error) {
+        std::rethrow_exception(this->d_error);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+#endif
@@ -26,75 +26,418 @@
 #ifndef INCLUDED_THREAD_POOL
 #define INCLUDED_THREAD_POOL
 
+#include "job.hpp"
+#include "job_list.hpp"
+#include "job_queue.hpp"
+#include "idle_policy.hpp"
+#include "latch.hpp"
+#include "pool_stats.hpp"
+#include "scratch.hpp"
+#include "topology.hpp"
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
-#include <deque>
-#include <functional>
+#include <cstddef>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <utility>
 #include <vector>
+#if 202002L <= __cplusplus
+#include <coroutine>
+#endif
 
 // ----------------------------------------------------------------------------
 
 namespace nstd {
-    class thread_pool;
+    template <typename Queue = nstd::locked_job_queue>
+    class basic_thread_pool;
+    using thread_pool = basic_thread_pool<>;
+
+    nstd::thread_pool& default_pool();
 }
 
 // ----------------------------------------------------------------------------
+// The pool can either funnel all jobs through one shared queue or use work
+// stealing: with work stealing each worker owns a deque. Jobs enqueued from
+// a worker go to the back of that worker's deque and are processed LIFO by
+// the worker itself while idle workers steal from the front. Jobs enqueued
+// from other threads still go to the shared queue. The type of the shared
+// queue is the template parameter, e.g., the lock-free mpmc_job_queue can be
+// used instead of the default locked_job_queue (see job_queue.hpp).
+//
+// Jobs are stored as nstd::job in nodes taken from a per-pool slab. Workers
+// keep a small cache of free nodes to avoid contention on the slab; other
+// threads take nodes directly from the slab's lock-free free list.
+//
+// Before starting the pool the workers can be set up to be pinned to CPUs
+// according to the machine's topology (see nstd::cpu_topology). How idle
+// workers wait for new jobs is determined by an nstd::idle_policy.
+//
+// Jobs can get temporary memory from this_worker::scratch() which is valid
+// until the job returns (see scratch.hpp).
+//
+// When compiled with NSTD_THREAD_POOL_STATS, stats() provides a snapshot of
+// per-worker counters (see nstd::pool_counters).
+//
+// Parallel algorithms can reserve() a share of the workers to size their
+// number of jobs: the pool hands out at most thread_count() workers in
+// total to the budgets alive at any one time. Concurrent or nested uses of
+// algorithms thus don't flood the pool with jobs which merely wait.
+//
+// Jobs are enqueued with a priority: high priority jobs go to a separate
+// shared lane which workers check before their normal work. To avoid
+// starving normal jobs, after a streak of starvation_limit() high priority
+// jobs a normal job gets a turn if there is one.
+//
+// With C++20 a coroutine can move itself onto the pool using
+// co_await pool.schedule() (see coroutine.hpp for nstd::task).
+
+template <typename Queue>
+class nstd::basic_thread_pool {
+public:
+    enum class mode { shared_queue, work_stealing };
+    enum class placement { none, compact, scatter, numa_node };
+    enum class priority { normal, high };
+
+    class budget {
+    private:
+        std::atomic<int>* d_tokens;
+        int               d_count;
+
+    public:
+        budget(std::atomic<int>* tokens, int count)
+            : d_tokens(tokens)
+            , d_count(count) {
+        }
+        budget(budget&& other)
+            : d_tokens(other.d_tokens)
+            , d_count(other.d_count) {
+            other.d_tokens = nullptr;
+        }
+        budget(budget&) = delete;
+        void operator=(budget&) = delete;
+        ~budget() {
+            if (this->d_tokens && this->d_count) {
+                *this->d_tokens += this->d_count;
+            }
+        }
+        int count() const { return this->d_count; }
+    };
+
+#if 202002L <= __cplusplus
+    class schedule_awaitable {
+    private:
+        basic_thread_pool* d_pool;
+        priority     d_priority;
+
+    public:
+        schedule_awaitable(basic_thread_pool* pool, priority p): d_pool(pool), d_priority(p) {}
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            this->d_pool->enqueue_job([handle]{ handle.resume(); }, this->d_priority);
+        }
+        void await_resume() const noexcept {}
+    };
+#endif
 
-class nstd::thread_pool {
 private:
-    int                               d_count;
-    std::mutex                        d_mutex;
-    std::condition_variable           d_condition;
-    std::vector<std::thread>          d_threads;
-    std::deque<std::function<void()>> d_jobs;
-    bool                              d_running;
-
-    bool process_job() {
-        std::function<void()> fun;
-        {
-            std::unique_lock<std::mutex> kerberos(this->d_mutex);
-            while (this->d_jobs.empty() && this->d_running) {
-                this->d_condition.wait(kerberos);
+    static constexpr std::size_t cache_batch = 32u;
+    using counters = nstd::pool_counters<NSTD_THREAD_POOL_STATS>;
+
+    struct worker {
+        std::mutex     d_mutex;
+        nstd::job_list d_jobs;
+        nstd::job_list d_free; // only accessed by the worker itself
+        int            d_node = -1;
+        counters       d_counters;
+        char           d_padding[64]; // avoid false sharing
+    };
+
+    int                       d_count;
+    mode                      d_mode;
+    placement                 d_placement;
+    nstd::idle_policy         d_idle;
+    nstd::job_slab            d_slab;
+    std::mutex                d_mutex;
+    std::condition_variable   d_condition;
+    std::vector<std::thread>  d_threads;
+    Queue                     d_queue;
+    std::atomic<int>          d_shared_count; // jobs in d_queue, approximately
+    nstd::job_list            d_urgent;
+    std::atomic<int>          d_urgent_count;
+    std::atomic<int>          d_streak;
+    int                       d_starvation_limit;
+    std::unique_ptr<worker[]> d_workers;
+    std::atomic<int>          d_pending;
+    std::atomic<int>          d_sleeping;
+    bool                      d_running;
+    std::atomic<int>          d_budget;
+    counters                  d_external;
+
+    static std::pair<basic_thread_pool*, int>& current() {
+        thread_local std::pair<basic_thread_pool*, int> rc(nullptr, -1);
+        return rc;
+    }
+    int worker_index() const {
+        auto const& cur(current());
+        return cur.first == this? cur.second: -1;
+    }
+    counters& counters_for(int index) {
+        return index < 0? this->d_external: this->d_workers[index].d_counters;
+    }
+
+    nstd::job_node* allocate(int index) {
+        if (index < 0) {
+            return this->d_slab.allocate();
+        }
+        nstd::job_list& cache(this->d_workers[index].d_free);
+        if (cache.empty()) {
+            this->d_slab.refill(cache, cache_batch);
+        }
+        return cache.pop_front();
+    }
+    void allocate(int index, nstd::job_list& nodes, std::size_t count) {
+        if (index < 0) {
+            return this->d_slab.refill(nodes, count);
+        }
+        nstd::job_list& cache(this->d_workers[index].d_free);
+        if (cache.size() < count) {
+            this->d_slab.refill(cache, count - cache.size() + cache_batch);
+        }
+        nodes.splice(cache, count);
+    }
+    void release(int index, nstd::job_node* node) {
+        node->d_job.reset();
+        if (index < 0) {
+            return this->d_slab.release(node);
+        }
+        nstd::job_list& cache(this->d_workers[index].d_free);
+        cache.push_back(node);
+        if (2u * cache_batch < cache.size()) {
+            this->d_slab.drain(cache, cache_batch);
+        }
+    }
+
+    nstd::job_node* pop_local(int index) {
+        worker& self(this->d_workers[index]);
+        std::lock_guard<std::mutex> kerberos(self.d_mutex);
+        return self.d_jobs.pop_back();
+    }
+    nstd::job_node* pop_shared() {
+        // idle workers poll: avoid touching the queue when it is empty
+        if (this->d_shared_count.load(std::memory_order_relaxed) <= 0) {
+            return nullptr;
+        }
+        nstd::job_node* node(this->d_queue.pop());
+        if (node) {
+            --this->d_shared_count;
+        }
+        return node;
+    }
+    nstd::job_node* steal(int index) {
+        for (int i(1); i <= this->d_count; ++i) {
+            int victim_index((index + i) % this->d_count);
+            if (victim_index == index) {
+                continue;
             }
-            if (this->d_jobs.empty()) {
+            worker& victim(this->d_workers[victim_index]);
+            std::unique_lock<std::mutex> kerberos(victim.d_mutex, std::try_to_lock);
+            if (kerberos.owns_lock() && !victim.d_jobs.empty()) {
+                this->counters_for(index).steal();
+                return victim.d_jobs.pop_front();
+            }
+        }
+        return nullptr;
+    }
+    nstd::job_node* pop_urgent() {
+        if (0 == this->d_urgent_count.load(std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> kerberos(this->d_mutex);
+        nstd::job_node* node(this->d_urgent.pop_front());
+        if (node) {
+            --this->d_urgent_count;
+        }
+        return node;
+    }
+    nstd::job_node* pop_normal(int index) {
+        if (this->d_mode == mode::shared_queue) {
+            return this->pop_shared();
+        }
+        nstd::job_node* node(0 <= index? this->pop_local(index): nullptr);
+        if (!node) {
+            node = this->pop_shared();
+        }
+        if (!node) {
+            node = this->steal(index);
+        }
+        return node;
+    }
+    nstd::job_node* try_pop(int index) {
+        nstd::job_node* node(nullptr);
+        if (this->d_streak.load(std::memory_order_relaxed) < this->d_starvation_limit
+            && (node = this->pop_urgent())) {
+            this->d_streak.fetch_add(1, std::memory_order_relaxed);
+            return node;
+        }
+        // either there is no high priority job or normal jobs get a turn
+        node = this->pop_normal(index);
+        if (0 != this->d_streak.load(std::memory_order_relaxed)) {
+            this->d_streak.store(0, std::memory_order_relaxed);
+        }
+        return node? node: this->pop_urgent();
+    }
+
+    void execute(int index, nstd::job_node* node) {
+        counters&                     stats(this->counters_for(index));
+        counters::time_point          start(counters::now());
+        nstd::scratch_arena&          scratch(nstd::this_worker::arena());
+        nstd::scratch_arena::position mark(scratch.mark());
+        --this->d_pending;
+        try {
+            node->d_job();
+        }
+        catch (std::exception const& ex) {
+            stats.exception();
+            std::cerr << "ERROR: " << ex.what() << "\n";
+        }
+        catch (...) {
+            stats.exception();
+            std::cerr << "ERROR: caught unkonwn error\n";
+        }
+        scratch.release(mark);
+        this->release(index, node);
+        stats.busy(start);
+    }
+    void release(int index, nstd::job_list& nodes) {
+        while (!nodes.empty()) {
+            this->release(index, nodes.pop_front());
+        }
+    }
+    void publish(int index, nstd::job_list& nodes, priority p) {
+        int count(int(nodes.size()));
+        this->counters_for(index).submit(count);
+        if (p == priority::high) {
+            std::lock_guard<std::mutex> kerberos(this->d_mutex);
+            this->d_urgent.splice(nodes);
+            this->d_urgent_count += count;
+            this->d_pending += count;
+            this->notify(count);
+        }
+        else if (this->d_mode == mode::work_stealing && 0 <= index) {
+            {
+                worker& self(this->d_workers[index]);
+                std::lock_guard<std::mutex> kerberos(self.d_mutex);
+                self.d_jobs.splice(nodes);
+                self.d_counters.queue_depth(self.d_jobs.size());
+            }
+            this->d_pending += count;
+            if (0 < this->d_sleeping) {
+                // the lock makes sure a worker about to sleep gets notified
+                std::lock_guard<std::mutex> kerberos(this->d_mutex);
+                this->notify(count);
+            }
+        }
+        else {
+            this->d_queue.push(nodes);
+            int depth(this->d_shared_count += count);
+            if (NSTD_THREAD_POOL_STATS) {
+                this->d_external.queue_depth(std::size_t(std::max(0, depth)));
+            }
+            this->d_pending += count;
+            if (0 < this->d_sleeping) {
+                std::lock_guard<std::mutex> kerberos(this->d_mutex);
+                this->notify(count);
+            }
+        }
+    }
+    void notify(int count) {
+        // wake at most as many workers as there are new jobs
+        for (int sleeping(this->d_sleeping); 0 < count && 0 < sleeping; --count, --sleeping) {
+            this->d_condition.notify_one();
+        }
+    }
+    bool await_job() {
+        for (int i(0); i < this->d_idle.spins; ++i) {
+            if (0 < this->d_pending) {
+                return true;
+            }
+            nstd::cpu_relax();
+        }
+        for (int i(0); i < this->d_idle.yields; ++i) {
+            if (0 < this->d_pending) {
+                return true;
+            }
+            std::this_thread::yield();
+        }
+        std::unique_lock<std::mutex> kerberos(this->d_mutex);
+        ++this->d_sleeping;
+        while (0 == this->d_pending && this->d_running) {
+            this->d_condition.wait(kerberos);
+        }
+        --this->d_sleeping;
+        return 0 != this->d_pending;
+    }
+    bool process_job(int index) {
+        counters::time_point start(counters::now());
+        nstd::job_node*      node;
+        while (!(node = this->try_pop(index))) {
+            if (!this->await_job()) {
                 return false;
             }
-            fun = std::move(this->d_jobs.front());
-            this->d_jobs.pop_front();
         }
-        fun();
+        this->d_workers[index].d_counters.idle(start);
+        this->execute(index, node);
         return true;
     }
 
 public:
-    explicit thread_pool(int count)
+    explicit basic_thread_pool(int count, mode m = mode::shared_queue)
         : d_count(count)
-        , d_running(false) {
+        , d_mode(m)
+        , d_placement(placement::none)
+        , d_idle(nstd::idle_policy::park())
+        , d_shared_count(0)
+        , d_urgent_count(0)
+        , d_streak(0)
+        , d_starvation_limit(16)
+        , d_workers(new worker[count])
+        , d_pending(0)
+        , d_sleeping(0)
+        , d_running(false)
+        , d_budget(count) {
         this->d_threads.reserve(count);
     }
-    thread_pool(thread_pool&) = delete;
-    void operator=(thread_pool&) = delete;
-    ~thread_pool(){ this->stop(); }
+    basic_thread_pool(basic_thread_pool&) = delete;
+    void operator=(basic_thread_pool&) = delete;
+    ~basic_thread_pool(){ this->stop(); }
 
+    void set_placement(placement p) { this->d_placement = p; }
+    void set_idle_policy(nstd::idle_policy policy) { this->d_idle = policy; }
+    void set_starvation_limit(int limit) { this->d_starvation_limit = std::max(1, limit); }
+    int starvation_limit() const { return this->d_starvation_limit; }
     void start() {
         std::lock_guard<std::mutex> kerberos(this->d_mutex);
+        nstd::cpu_topology const& topology(nstd::cpu_topology::instance());
+        std::vector<nstd::cpu_topology::slot> slots;
+        switch (this->d_placement) {
+        case placement::none:                                                 break;
+        case placement::compact:   slots = topology.compact(this->d_count);    break;
+        case placement::scatter:   slots = topology.scatter(this->d_count);    break;
+        case placement::numa_node: slots = topology.numa_nodes(this->d_count); break;
+        }
         this->d_running = true;
         for (int i(0); i != this->d_count; ++i) {
-            this->d_threads.emplace_back(std::thread([this]{
-                        while (true) {
-                            try {
-                                if (!this->process_job()) {
-                                    break;
-                                }
-                            }
-                            catch (std::exception const& ex) {
-                                std::cerr << "ERROR: " << ex.what() << "\n";
-                            }
-                            catch (...) {
-                                std::cerr << "ERROR: caught unkonwn error\n";
-                            }
+            this->d_workers[i].d_node = slots.empty()? -1: slots[i].node;
+            std::vector<int> cpus(slots.empty()? std::vector<int>(): slots[i].cpus);
+            this->d_threads.emplace_back(std::thread([this, i, cpus]{
+                        current() = std::make_pair(this, i);
+                        if (!cpus.empty()) {
+                            nstd::cpu_topology::bind_this_thread(cpus);
+                        }
+                        while (this->process_job(i)) {
                         }
                     }));
         }
@@ -119,15 +462,147 @@ public:
         }
     }
     int thread_count() const { return this->d_count; }
-    void enqueue_job(std::function<void()> job) {
-        {
-            std::lock_guard<std::mutex> kerberos(this->d_mutex);
-            this->d_jobs.push_back(std::move(job));
+    // Reserve up to requested workers: the result holds the number of
+    // workers which aren't reserved by other budgets, possibly zero, until
+    // it is destroyed.
+    budget reserve(int requested) {
+        int available(this->d_budget);
+        int granted;
+        do {
+            granted = std::max(0, std::min(requested, available));
         }
-        this->d_condition.notify_one();
+        while (granted && !this->d_budget.compare_exchange_weak(available, available - granted));
+        return budget(&this->d_budget, granted);
+    }
+    int available() const { return std::max(0, this->d_budget.load()); }
+#if 202002L <= __cplusplus
+    // Awaiting the result resumes the awaiting coroutine on a worker.
+    schedule_awaitable schedule(priority p = priority::normal) {
+        return schedule_awaitable(this, p);
+    }
+#endif
+
+    nstd::pool_stats stats() const {
+        nstd::pool_stats rc;
+        rc.enabled = NSTD_THREAD_POOL_STATS;
+        for (int i(0); i != this->d_count; ++i) {
+            rc.workers.push_back(this->d_workers[i].d_counters.snapshot());
+        }
+        rc.external = this->d_external.snapshot();
+        return rc;
+    }
+    // The NUMA node of the calling thread: the node a worker was placed on
+    // or, for unplaced threads, the node of the CPU the thread runs on.
+    int current_node() const {
+        int index(this->worker_index());
+        if (0 <= index && 0 <= this->d_workers[index].d_node) {
+            return this->d_workers[index].d_node;
+        }
+        return nstd::cpu_topology::instance().current_node();
+    }
+
+    // Run one pending job on the calling thread if there is any. Returns
+    // true if a job was run.
+    bool run_pending_job() {
+        int             index(this->worker_index());
+        nstd::job_node* node(this->try_pop(index));
+        if (node) {
+            this->execute(index, node);
+        }
+        return node != nullptr;
+    }
+    // Wait for the latch to be released, running pending jobs meanwhile:
+    // a job waiting for nested jobs doesn't tie up its worker and it is
+    // safe to fork and join from within jobs even with one worker.
+    template <typename Latch>
+    void join(Latch& latch) {
+        while (!latch.try_wait()) {
+            if (!this->run_pending_job()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    template <typename Job>
+    void enqueue_job(Job&& job, priority p = priority::normal) {
+        int             index(this->worker_index());
+        nstd::job_node* node(this->allocate(index));
+        try {
+            node->d_job.emplace(std::forward<Job>(job));
+        }
+        catch (...) {
+            this->release(index, node);
+            throw;
+        }
+        nstd::job_list nodes;
+        nodes.push_back(node);
+        this->publish(index, nodes, p);
+    }
+    // Enqueue the jobs fun(0), ..., fun(count - 1) at once: the queue is
+    // locked once and only as many workers as needed are woken up. fun is
+    // copied into each of the jobs, i.e., it should be cheap to copy.
+    template <typename Fun>
+    void enqueue_bulk(int count, Fun fun, priority p = priority::normal) {
+        if (count <= 0) {
+            return;
+        }
+        int            index(this->worker_index());
+        nstd::job_list nodes, jobs;
+        this->allocate(index, nodes, count);
+        try {
+            for (int i(0); i != count; ++i) {
+                nstd::job_node* node(nodes.pop_front());
+                jobs.push_back(node);
+                node->d_job.emplace([fun, i]{ fun(i); });
+            }
+        }
+        catch (...) {
+            this->release(index, jobs);
+            this->release(index, nodes);
+            throw;
+        }
+        this->publish(index, jobs, p);
+    }
+    // Run fun(0), ..., fun(count - 1) on the pool and wait for completion
+    // while helping with pending jobs.
+    template <typename Fun>
+    void parallel_invoke(int count, Fun&& fun) {
+        nstd::latch latch(count);
+        this->enqueue_bulk(count, [&fun, &latch](int i){
+                try {
+                    fun(i);
+                }
+                catch (...) {
+                    latch.arrive();
+                    throw;
+                }
+                latch.arrive();
+            });
+        this->join(latch);
     }
 };
 
+// ----------------------------------------------------------------------------
+// The process-wide pool used by the algorithms when no pool is passed: it is
+// started upon first use with one work stealing worker per hardware thread
+// placed on the NUMA nodes. The workers spin briefly before parking, i.e.,
+// they are warm for back-to-back algorithm calls.
+
+inline nstd::thread_pool& nstd::default_pool() {
+    struct started_pool
+        : nstd::thread_pool {
+        started_pool()
+            : nstd::thread_pool(std::max(1u, std::thread::hardware_concurrency()),
+                                nstd::thread_pool::mode::work_stealing) {
+            this->set_placement(nstd::thread_pool::placement::numa_node);
+            this->set_idle_policy(nstd::idle_policy::spin_then_park());
+            this->start();
+        }
+    };
+    static started_pool rc;
+    return rc;
+}
+
 // ----------------------------------------------------------------------------
 
 #endif
@@ -0,0 +1,249 @@
+// topology.hpp                                                      -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#ifndef INCLUDED_TOPOLOGY
+#define INCLUDED_TOPOLOGY
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// ----------------------------------------------------------------------------
+// nstd::cpu_topology describes the CPUs of the machine as read from the
+// Linux sysfs (/sys/devices/system/{cpu,node}): for each CPU the core, the
+// package, and the NUMA node it belongs to. On other systems, or if sysfs
+// isn't readable, all hardware threads are put on one node with one CPU per
+// core. The topology is used to determine where to place the threads of a
+// thread pool:
+//
+// - compact:   fill the hardware threads of one core, package, and node
+//              before moving to the next one.
+// - scatter:   spread the threads over the nodes and cores, using the
+//              hyper-threads of a core only once all cores are in use.
+// - numa_node: assign consecutive workers to the same node, allowing them
+//              to run on any of the CPUs of that node.
+
+namespace nstd {
+    class cpu_topology;
+}
+
+// ----------------------------------------------------------------------------
+
+class nstd::cpu_topology {
+public:
+    struct cpu {
+        int id;
+        int core;
+        int package;
+        int node;
+    };
+    struct slot {
+        int              node;
+        std::vector<int> cpus;
+    };
+
+private:
+    std::vector<cpu> d_cpus;
+    std::vector<int> d_node_of; // indexed by the CPU id
+    int              d_nodes;
+
+    static std::string read_line(std::string const& path) {
+        std::ifstream in(path);
+        std::string   line;
+        std::getline(in, line);
+        return line;
+    }
+    static int read_int(std::string const& path, int fallback) {
+        std::string line(read_line(path));
+        return line.empty()? fallback: std::atoi(line.c_str());
+    }
+    static std::vector<int> parse_list(std::string const& list) {
+        // the format is a comma separated list of ranges like "0-3,8-11,16"
+        std::vector<int>  rc;
+        std::stringstream in(list);
+        for (std::string range; std::getline(in, range, ','); ) {
+            std::size_t dash(range.find('-'));
+            int first(std::atoi(range.c_str()));
+            int last(dash == range.npos? first: std::atoi(range.c_str() + dash + 1));
+            for (; !range.empty() && first <= last; ++first) {
+                rc.push_back(first);
+            }
+        }
+        return rc;
+    }
+
+public:
+    cpu_topology()
+        : d_nodes(1) {
+        std::string const base("/sys/devices/system/");
+        for (int id: parse_list(read_line(base + "cpu/online"))) {
+            std::string dir(base + "cpu/cpu" + std::to_string(id) + "/topology/");
+            this->d_cpus.push_back(cpu{ id,
+                                        read_int(dir + "core_id", id),
+                                        read_int(dir + "physical_package_id", 0),
+                                        0 });
+        }
+        if (this->d_cpus.empty()) {
+            int count(std::max(1u, std::thread::hardware_concurrency()));
+            for (int id(0); id != count; ++id) {
+                this->d_cpus.push_back(cpu{ id, id, 0, 0 });
+            }
+        }
+        std::vector<int> nodes(parse_list(read_line(base + "node/online")));
+        for (int node: nodes) {
+            std::string list(base + "node/node" + std::to_string(node) + "/cpulist");
+            for (int id: parse_list(read_line(list))) {
+                for (cpu& c: this->d_cpus) {
+                    if (c.id == id) {
+                        c.node = node;
+                    }
+                }
+            }
+            this->d_nodes = std::max(this->d_nodes, node + 1);
+        }
+        for (cpu const& c: this->d_cpus) {
+            if (int(this->d_node_of.size()) <= c.id) {
+                this->d_node_of.resize(c.id + 1, 0);
+            }
+            this->d_node_of[c.id] = c.node;
+        }
+    }
+    static cpu_topology const& instance() {
+        static cpu_topology rc;
+        return rc;
+    }
+
+    std::vector<cpu> const& cpus() const { return this->d_cpus; }
+    int node_count() const { return this->d_nodes; }
+    int node_of(int id) const {
+        return 0 <= id && id < int(this->d_node_of.size())? this->d_node_of[id]: 0;
+    }
+    int current_node() const {
+#ifdef __linux__
+        int id(sched_getcpu());
+        return id < 0? 0: this->node_of(id);
+#else
+        return 0;
+#endif
+    }
+
+    std::vector<slot> compact(int count) const {
+        std::vector<cpu> cpus(this->d_cpus);
+        std::sort(cpus.begin(), cpus.end(), [](cpu const& c0, cpu const& c1){
+                return std::tie(c0.node, c0.package, c0.core, c0.id)
+                    <  std::tie(c1.node, c1.package, c1.core, c1.id);
+            });
+        std::vector<slot> rc;
+        for (int i(0); i != count; ++i) {
+            cpu const& c(cpus[i % cpus.size()]);
+            rc.push_back(slot{ c.node, { c.id } });
+        }
+        return rc;
+    }
+    std::vector<slot> scatter(int count) const {
+        // rank the hardware threads within their core, then interleave the
+        // nodes, packages, and cores within each rank
+        std::vector<std::tuple<int, int, int, int, int>> order;
+        for (cpu const& c: this->d_cpus) {
+            int rank(0), index(0);
+            for (cpu const& o: this->d_cpus) {
+                if (o.package == c.package && o.core == c.core && o.id < c.id) {
+                    ++rank;
+                }
+                if (o.node == c.node && o.id < c.id) {
+                    ++index;
+                }
+            }
+            order.emplace_back(rank, index, c.node, c.id, c.package);
+        }
+        std::sort(order.begin(), order.end());
+        std::vector<slot> rc;
+        for (int i(0); i != count; ++i) {
+            auto const& o(order[i % order.size()]);
+            rc.push_back(slot{ std::get<2>(o), { std::get<3>(o) } });
+        }
+        return rc;
+    }
+    std::vector<slot> numa_nodes(int count) const {
+        std::vector<slot> nodes;
+        for (int node(0); node != this->d_nodes; ++node) {
+            slot s{ node, {} };
+            for (cpu const& c: this->d_cpus) {
+                if (c.node == node) {
+                    s.cpus.push_back(c.id);
+                }
+            }
+            if (!s.cpus.empty()) {
+                nodes.push_back(s);
+            }
+        }
+        std::vector<slot> rc;
+        for (int i(0); i != count; ++i) {
+            rc.push_back(nodes[i * nodes.size() / count]);
+        }
+        return rc;
+    }
+
+    static bool bind_this_thread(std::vector<int> const& cpus) {
+#ifdef __linux__
+        // the CPU ids come from sysfs and may exceed CPU_SETSIZE
+        int count(1);
+        for (int id: cpus) {
+            count = std::max(count, id + 1);
+        }
+        cpu_set_t* set(CPU_ALLOC(count));
+        if (!set) {
+            return false;
+        }
+        std::size_t size(CPU_ALLOC_SIZE(count));
+        CPU_ZERO_S(size, set);
+        for (int id: cpus) {
+            if (0 <= id) {
+                CPU_SET_S(id, size, set);
+            }
+        }
+        bool rc(0 == pthread_setaffinity_np(pthread_self(), size, set));
+        CPU_FREE(set);
+        return rc;
+#else
+        (void)cpus;
+        return false;
+#endif
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,303 @@
+// tuning.hpp                                                        -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#ifndef INCLUDED_TUNING
+#define INCLUDED_TUNING
+
+#include "block_manager.hpp"
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <atomic>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// The performance constants of the partition and sort algorithms depend on
+// the machine and the element size. They are taken from a tuning profile
+// which is loaded when first used from the file named by the environment
+// variable NSTD_TUNING_PROFILE or, otherwise, from ~/.nstd_tuning. The
+// autotune program calibrates the parameters and writes the profile. The
+// file has one line per element size (0 is used for sizes without a line):
+//
+//   # element_size block_size min_blocks sort_cutoff context_min_block context_blocks_per_thread block_manager
+//   4 2048 8 16000 256 8 packed
+//
+// Without a profile the parameters are the values the algorithms always
+// used. The block size is a template argument of the block managers, i.e.,
+// it is rounded down to a power of two between 256 and 8192. Lines with
+// parameters which can't work (see tuning_parameters::valid()) are ignored.
+
+namespace nstd {
+    enum class block_manager_kind {
+        mutex, atomic, padded_atomic, relaxed, guided, packed, numa
+    };
+    template <template <typename, int> class BlockManager>
+    struct block_manager_tag {};
+    struct tuning_parameters;
+    class tuning_profile;
+    class tuning_override;
+
+    char const* to_string(nstd::block_manager_kind kind);
+    bool from_string(std::string const& name, nstd::block_manager_kind& kind);
+
+    template <typename RndIt>
+    nstd::tuning_parameters tuning_for();
+    template <typename Fun>
+    auto with_block_size(int size, Fun&& fun)
+        -> decltype(fun(std::integral_constant<int, 1024>()));
+    template <typename Fun>
+    auto with_block_manager(nstd::block_manager_kind kind, Fun&& fun)
+        -> decltype(fun(nstd::block_manager_tag<nstd::block_manager_relaxed>()));
+}
+
+// ----------------------------------------------------------------------------
+
+struct nstd::tuning_parameters {
+    std::size_t              element_size              = 0u;
+    int                      block_size                = 1024;
+    int                      min_blocks                = 4;
+    long                     sort_cutoff               = 8000;
+    long                     context_min_block         = 128;
+    int                      context_blocks_per_thread = 8;
+    nstd::block_manager_kind block_manager             = nstd::block_manager_kind::relaxed;
+
+    bool valid() const {
+        return 1 <= this->block_size
+            && 1 <= this->min_blocks
+            && 2 <= this->sort_cutoff // the sort partitions around the last element
+            && 1 <= this->context_min_block
+            && 1 <= this->context_blocks_per_thread;
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+inline char const* nstd::to_string(nstd::block_manager_kind kind) {
+    switch (kind) {
+    case nstd::block_manager_kind::mutex:         return "mutex";
+    case nstd::block_manager_kind::atomic:        return "atomic";
+    case nstd::block_manager_kind::padded_atomic: return "padded_atomic";
+    case nstd::block_manager_kind::relaxed:       return "relaxed";
+    case nstd::block_manager_kind::guided:        return "guided";
+    case nstd::block_manager_kind::packed:        return "packed";
+    case nstd::block_manager_kind::numa:          return "numa";
+    }
+    return "relaxed";
+}
+
+inline bool nstd::from_string(std::string const& name, nstd::block_manager_kind& kind) {
+    for (auto k: { nstd::block_manager_kind::mutex,
+                   nstd::block_manager_kind::atomic,
+                   nstd::block_manager_kind::padded_atomic,
+                   nstd::block_manager_kind::relaxed,
+                   nstd::block_manager_kind::guided,
+                   nstd::block_manager_kind::packed,
+                   nstd::block_manager_kind::numa }) {
+        if (name == nstd::to_string(k)) {
+            kind = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+// The profile used by the algorithms is loaded once and isn't changed
+// afterwards: instance() is immutable and tuning_for() caches the
+// parameters per element size, i.e., the algorithms don't synchronize on
+// the profile. Other profiles (e.g., to be saved by the autotuner) aren't
+// meant to be shared between threads while they are changed.
+
+class nstd::tuning_profile {
+private:
+    std::vector<nstd::tuning_parameters> d_entries;
+
+public:
+    static std::string default_path() {
+        if (char const* path = std::getenv("NSTD_TUNING_PROFILE")) {
+            return path;
+        }
+        char const* home(std::getenv("HOME"));
+        return home? std::string(home) + "/.nstd_tuning": std::string();
+    }
+    static tuning_profile const& instance() {
+        static tuning_profile rc(default_path());
+        return rc;
+    }
+
+    tuning_profile() = default;
+    explicit tuning_profile(std::string const& path) { this->load(path); }
+    tuning_profile(tuning_profile&) = delete;
+    void operator=(tuning_profile&) = delete;
+
+    nstd::tuning_parameters get(std::size_t element_size) const {
+        nstd::tuning_parameters rc;
+        for (auto const& entry: this->d_entries) {
+            if (entry.element_size == element_size) {
+                return entry;
+            }
+            if (entry.element_size == 0u) {
+                rc = entry;
+            }
+        }
+        rc.element_size = element_size;
+        return rc;
+    }
+    // invalid parameters are rejected
+    bool set(nstd::tuning_parameters const& parameters) {
+        if (!parameters.valid()) {
+            return false;
+        }
+        for (auto& entry: this->d_entries) {
+            if (entry.element_size == parameters.element_size) {
+                entry = parameters;
+                return true;
+            }
+        }
+        this->d_entries.push_back(parameters);
+        return true;
+    }
+
+    bool load(std::string const& path) {
+        std::ifstream in(path);
+        if (path.empty() || !in) {
+            return false;
+        }
+        for (std::string line; std::getline(in, line); ) {
+            std::istringstream      lin(line);
+            nstd::tuning_parameters entry;
+            std::string             manager;
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            if (lin >> entry.element_size >> entry.block_size >> entry.min_blocks
+                    >> entry.sort_cutoff >> entry.context_min_block
+                    >> entry.context_blocks_per_thread >> manager
+                && nstd::from_string(manager, entry.block_manager)) {
+                this->set(entry);
+            }
+        }
+        return true;
+    }
+    bool save(std::string const& path) const {
+        std::ofstream out(path);
+        out << "# element_size block_size min_blocks sort_cutoff"
+            << " context_min_block context_blocks_per_thread block_manager\n";
+        for (auto const& entry: this->d_entries) {
+            out << entry.element_size << ' ' << entry.block_size << ' '
+                << entry.min_blocks << ' ' << entry.sort_cutoff << ' '
+                << entry.context_min_block << ' ' << entry.context_blocks_per_thread << ' '
+                << nstd::to_string(entry.block_manager) << '\n';
+        }
+        return bool(out);
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+// An override replaces the parameters for their element size while it
+// exists, e.g., to calibrate them: the parameters are referenced, not
+// copied. Overrides nest but aren't meant to be used by concurrent threads.
+
+class nstd::tuning_override {
+private:
+    nstd::tuning_parameters const* d_previous;
+
+public:
+    static std::atomic<nstd::tuning_parameters const*>& current() {
+        static std::atomic<nstd::tuning_parameters const*> rc(nullptr);
+        return rc;
+    }
+
+    explicit tuning_override(nstd::tuning_parameters const& parameters)
+        : d_previous(current().exchange(&parameters, std::memory_order_acq_rel)) {
+    }
+    tuning_override(tuning_override&) = delete;
+    void operator=(tuning_override&) = delete;
+    ~tuning_override() {
+        current().store(this->d_previous, std::memory_order_release);
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+template <typename RndIt>
+nstd::tuning_parameters nstd::tuning_for() {
+    using value_type = typename std::iterator_traits<RndIt>::value_type;
+    nstd::tuning_parameters const* active(
+        nstd::tuning_override::current().load(std::memory_order_acquire));
+    if (active && active->element_size == sizeof(value_type)) {
+        return *active;
+    }
+    static nstd::tuning_parameters const rc(
+        nstd::tuning_profile::instance().get(sizeof(value_type)));
+    return rc;
+}
+
+// ----------------------------------------------------------------------------
+// Call fun with the block size as std::integral_constant: the largest
+// compiled in block size not exceeding size (but at least the smallest).
+
+template <typename Fun>
+auto nstd::with_block_size(int size, Fun&& fun)
+    -> decltype(fun(std::integral_constant<int, 1024>())) {
+    if (8192 <= size) { return fun(std::integral_constant<int, 8192>()); }
+    if (4096 <= size) { return fun(std::integral_constant<int, 4096>()); }
+    if (2048 <= size) { return fun(std::integral_constant<int, 2048>()); }
+    if (1024 <= size) { return fun(std::integral_constant<int, 1024>()); }
+    if (512  <= size) { return fun(std::integral_constant<int, 512>()); }
+    return fun(std::integral_constant<int, 256>());
+}
+
+template <typename Fun>
+auto nstd::with_block_manager(nstd::block_manager_kind kind, Fun&& fun)
+    -> decltype(fun(nstd::block_manager_tag<nstd::block_manager_relaxed>())) {
+    switch (kind) {
+    case nstd::block_manager_kind::mutex:
+        return fun(nstd::block_manager_tag<nstd::block_manager>());
+    case nstd::block_manager_kind::atomic:
+        return fun(nstd::block_manager_tag<nstd::block_manager_atomic>());
+    case nstd::block_manager_kind::padded_atomic:
+        return fun(nstd::block_manager_tag<nstd::block_manager_padded_atomic>());
+    case nstd::block_manager_kind::guided:
+        return fun(nstd::block_manager_tag<nstd::block_manager_guided>());
+    case nstd::block_manager_kind::packed:
+        return fun(nstd::block_manager_tag<nstd::block_manager_packed>());
+    case nstd::block_manager_kind::numa:
+        return fun(nstd::block_manager_tag<nstd::block_manager_numa>());
+    case nstd::block_manager_kind::relaxed:
+        break;
+    }
+    return fun(nstd::block_manager_tag<nstd::block_manager_relaxed>());
+}
+
+// ----------------------------------------------------------------------------
+
+#endif
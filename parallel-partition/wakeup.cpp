@@ -0,0 +1,97 @@
+// wakeup.cpp                                                        -*-C++-*-
+// ----------------------------------------------------------------------------
+//  Copyright (C) 2017 Dietmar Kuehl http://www.dietmar-kuehl.de         
+//                                                                       
+//  Permission is hereby granted, free of charge, to any person          
+//  obtaining a copy of this software and associated documentation       
+//  files (the "Software"), to deal in the Software without restriction, 
+//  including without limitation the rights to use, copy, modify,        
+//  merge, publish, distribute, sublicense, and/or sell copies of        
+//  the Software, and to permit persons to whom the Software is          
+//  furnished to do so, subject to the following conditions:             
+//                                                                       
+//  The above copyright notice and this permission notice shall be       
+//  included in all copies or substantial portions of the Software.      
+//                                                                       
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES      
+//  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND             
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT          
+//  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,         
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING         
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR        
+//  OTHER DEALINGS IN THE SOFTWARE. 
+// ----------------------------------------------------------------------------
+
+#include "idle_policy.hpp"
+#include "latch.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Measures the wake-up latency of idle workers, i.e., the time from
+// enqueuing a job until it starts executing, for different idle policies.
+// Between the jobs the submitting thread pauses, letting the workers become
+// idle like they do between the phases of a parallel algorithm.
+
+using clock_type = std::chrono::steady_clock;
+
+void measure(std::string const& name, nstd::idle_policy policy,
+             int workers, std::chrono::microseconds gap) {
+    constexpr int samples = 1000;
+    nstd::thread_pool pool(workers);
+    pool.set_idle_policy(policy);
+    pool.start();
+
+    std::vector<clock_type::duration> latencies;
+    latencies.reserve(samples);
+    for (int i(0); i != samples; ++i) {
+        std::this_thread::sleep_for(gap);
+        nstd::latch          latch(1);
+        clock_type::duration latency;
+        auto start = clock_type::now();
+        pool.enqueue_job([&]{
+                latency = clock_type::now() - start;
+                latch.arrive();
+            });
+        latch.wait();
+        latencies.push_back(latency);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto ns = [](clock_type::duration d){
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    };
+    std::cout << std::setw(20) << name << ' '
+              << "workers=" << std::setw(3) << workers << ' '
+              << "gap=" << std::setw(5) << gap.count() << "us "
+              << "median=" << std::setw(8) << ns(latencies[samples / 2]) << "ns "
+              << "p99=" << std::setw(8) << ns(latencies[samples * 99 / 100]) << "ns "
+              << '\n' << std::flush;
+}
+
+// ----------------------------------------------------------------------------
+
+int main() {
+    try {
+        int hardware(std::max(1u, std::thread::hardware_concurrency()));
+        for (int workers: { 1, hardware }) {
+            for (auto gap: { std::chrono::microseconds(10),
+                             std::chrono::microseconds(100),
+                             std::chrono::microseconds(1000) }) {
+                measure("park", nstd::idle_policy::park(), workers, gap);
+                measure("spin_then_park", nstd::idle_policy::spin_then_park(), workers, gap);
+                measure("low_latency", nstd::idle_policy::low_latency(), workers, gap);
+            }
+        }
+    }
+    catch (std::exception const& ex) {
+        std::cerr << "ERROR: " << ex.what() << '\n';
+    }
+}